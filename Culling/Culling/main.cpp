@@ -0,0 +1,436 @@
+//
+//  main.cpp
+//  Culling
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../../OpenGL/OpenGL/src/FrustumCuller.h"
+#include "../../OpenGL/OpenGL/src/MeshPool.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+int addCube(MeshPool& pool);
+int addOctahedron(MeshPool& pool);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// a GRID x GRID x GRID block of objects over [-WORLD, WORLD]; every MOVER_EVERY-th one bobs up
+// and down, so the hierarchy is refit every frame
+const int GRID = 50;
+const float WORLD = 100.0f;
+const int MOVER_EVERY = 8;
+const float FAR_PLANE = 80.0f;
+
+// every object reads its placement (position, size) from a texture buffer, at the slot the
+// pool gave its draw
+const char *vertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec3 aNormal;\n"
+"layout (location = 2) in uint aInstance;\n"
+"uniform samplerBuffer uPlacements;\n"
+"uniform mat4 uViewProjection;\n"
+"out vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   vec4 placement = texelFetch(uPlacements, int(aInstance));\n"
+"   gl_Position = uViewProjection * vec4(aPos * placement.w + placement.xyz, 1.0);\n"
+"   float hue = fract(dot(placement.xyz, vec3(0.013, 0.021, 0.017)));\n"
+"   float light = 0.35 + 0.65 * max(dot(aNormal, normalize(vec3(0.4, 0.8, 0.5))), 0.0);\n"
+"   ourColor = (0.5 + 0.5 * cos(6.2831853 * (hue + vec3(0.0, 0.33, 0.67)))) * light;\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(ourColor, 1.0f);\n"
+"}\n\0";
+
+struct Object
+{
+    float placement[4];   // center, half size
+    float phase;
+    int mesh;
+    uint32_t cullId;
+};
+
+
+int main(int argc, char **argv) {
+
+    // --no-bvh tests every box without the hierarchy and --no-cull draws everything, for
+    // comparison; --no-indirect draws one call per object
+    bool useHierarchy = true, cull = true, allowIndirect = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--no-bvh")
+            useHierarchy = false;
+        else if (argument == "--no-cull")
+            cull = false;
+        else if (argument == "--no-indirect")
+            allowIndirect = false;
+    }
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Culling", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+
+    // build and compile our shader program
+    // ------------------------------------
+    unsigned int shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+    GLint viewProjectionLocation = glGetUniformLocation(shaderProgram, "uViewProjection");
+    glUseProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "uPlacements"), 0);
+
+
+    // cubes and octahedra in one pair of buffers, and their boxes in the culler
+    // ------------------------------------------------------------------
+    const unsigned int objectCount = GRID * GRID * GRID;
+    MeshPool pool({{0, 3}, {1, 3}}, 2, 1024, 4096, objectCount, allowIndirect);
+    int meshes[] = { addCube(pool), addOctahedron(pool) };
+
+    std::srand(7);
+    auto random = [](float low, float high) { return low + (high - low) * (float)std::rand() / (float)RAND_MAX; };
+    std::vector<Object> objects(objectCount);
+    FrustumCuller culler;
+    const float cell = 2.0f * WORLD / GRID;
+    for (int z = 0; z < GRID; ++z)
+        for (int y = 0; y < GRID; ++y)
+            for (int x = 0; x < GRID; ++x)
+            {
+                Object& object = objects[(size_t)((z * GRID + y) * GRID + x)];
+                object.placement[0] = -WORLD + (x + random(0.3f, 0.7f)) * cell;
+                object.placement[1] = -WORLD + (y + random(0.3f, 0.7f)) * cell;
+                object.placement[2] = -WORLD + (z + random(0.3f, 0.7f)) * cell;
+                object.placement[3] = cell * random(0.15f, 0.3f);
+                object.phase = random(0.0f, 6.2831853f);
+                object.mesh = meshes[std::rand() % 2];
+
+                float minimum[3], maximum[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    minimum[k] = object.placement[k] - object.placement[3];
+                    maximum[k] = object.placement[k] + object.placement[3];
+                }
+                object.cullId = culler.add(minimum, maximum);
+            }
+    culler.rebuild();
+
+    // placements are written per frame, in draw order, to the slots the pool hands out
+    GLuint placementBuffer, placementTexture;
+    glGenBuffers(1, &placementBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, placementBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(objectCount * 4 * sizeof(float)), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glGenTextures(1, &placementTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, placementTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, placementBuffer);
+    std::vector<float> placements(objectCount * 4);
+    std::vector<uint32_t> visible;
+    visible.reserve(objectCount);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    Profiler profiler;
+    FrustumCuller::Stats totals;
+    unsigned long frames = 0;
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+        float time = (float)glfwGetTime();
+
+        // the movers bob, and the hierarchy's boxes follow them
+        profiler.begin("refit");
+        for (size_t i = 0; i < objects.size(); i += MOVER_EVERY)
+        {
+            Object& object = objects[i];
+            float center[3] = { object.placement[0], object.placement[1] + std::sin(time * 2.0f + object.phase) * cell * 0.4f, object.placement[2] };
+            float minimum[3], maximum[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                minimum[k] = center[k] - object.placement[3];
+                maximum[k] = center[k] + object.placement[3];
+            }
+            culler.setBounds(object.cullId, minimum, maximum);
+        }
+        culler.refit();
+        profiler.end();
+
+        // the camera circles inside the block, looking along its path
+        glm::vec3 eye(std::cos(time * 0.2f) * WORLD * 0.4f, std::sin(time * 0.35f) * WORLD * 0.1f, std::sin(time * 0.2f) * WORLD * 0.4f);
+        glm::vec3 ahead(-std::sin(time * 0.2f), 0.0f, std::cos(time * 0.2f));
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.5f, FAR_PLANE);
+        glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + ahead, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        // list what is on screen; only that reaches the pool
+        profiler.begin("cull");
+        Frustum frustum = Frustum::fromMatrix(viewProjection);
+        if (!cull)
+        {
+            visible.resize(objectCount);
+            for (uint32_t id = 0; id < objectCount; ++id)
+                visible[id] = id;
+        }
+        else if (useHierarchy)
+            culler.cull(frustum, visible);
+        else
+            culler.cullAll(frustum, visible);
+
+        pool.clear();
+        for (uint32_t id : visible)
+        {
+            const Object& object = objects[id];
+            GLuint slot = pool.draw(object.mesh);
+            for (int i = 0; i < 4; ++i)
+                placements[slot * 4 + (GLuint)i] = object.placement[i];
+            if (id % MOVER_EVERY == 0)
+                placements[slot * 4 + 1] += std::sin(time * 2.0f + object.phase) * cell * 0.4f;
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, placementBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(objectCount * 4 * sizeof(float)), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)(pool.drawCount() * 4 * sizeof(float)), placements.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        profiler.end();
+
+        if (cull)
+        {
+            const FrustumCuller::Stats& stats = culler.stats();
+            totals.nodes += stats.nodes;
+            totals.tested += stats.tested;
+            totals.culled += stats.culled;
+        }
+        totals.drawn += visible.size();
+        ++frames;
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        profiler.begin("submit");
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+        pool.submit();
+        pool.endFrame();
+        profiler.end();
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    unsigned long perFrame = frames > 0 ? frames : 1;
+    std::cout << "FRUSTUM_CULLING objects: " << objectCount << " per frame tested: " << totals.tested / perFrame << " culled: "
+              << totals.culled / perFrame << " drawn: " << totals.drawn / perFrame << " nodes: " << totals.nodes / perFrame << " ("
+              << (!cull ? "no culling" : useHierarchy ? "BVH" : "every box") << ", " << FrustumCuller::simdPath() << ")" << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteTextures(1, &placementTexture);
+    glDeleteBuffers(1, &placementBuffer);
+    glDeleteProgram(shaderProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+/*
+ a cube from -1 to 1, four vertices a face so each face has its own normal
+ */
+int addCube(MeshPool& pool)
+{
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    for (int axis = 0; axis < 3; ++axis)
+        for (int side = -1; side <= 1; side += 2)
+        {
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            GLuint first = (GLuint)(vertices.size() / 6);
+            float corners[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+            for (const float* corner : corners)
+            {
+                float position[3], normal[3] = { 0.0f, 0.0f, 0.0f };
+                position[axis] = (float)side;
+                position[u] = corner[0] * (float)side;   // mirrored on the negative side, so both wind outwards
+                position[v] = corner[1];
+                normal[axis] = (float)side;
+                vertices.insert(vertices.end(), position, position + 3);
+                vertices.insert(vertices.end(), normal, normal + 3);
+            }
+            GLuint quad[] = { first, first + 1, first + 2, first + 2, first + 3, first };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    return pool.add(vertices.data(), vertices.size() / 6, indices.data(), indices.size());
+}
+
+
+/*
+ an octahedron with its corners on the axes at distance 1, three vertices a face
+ */
+int addOctahedron(MeshPool& pool)
+{
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    for (int octant = 0; octant < 8; ++octant)
+    {
+        float sign[3] = { octant & 1 ? -1.0f : 1.0f, octant & 2 ? -1.0f : 1.0f, octant & 4 ? -1.0f : 1.0f };
+        float corners[3][3] = { { sign[0], 0.0f, 0.0f }, { 0.0f, sign[1], 0.0f }, { 0.0f, 0.0f, sign[2] } };
+        bool flip = sign[0] * sign[1] * sign[2] < 0.0f;   // keep every face counter-clockwise from outside
+        float normal[3] = { sign[0] * 0.57735f, sign[1] * 0.57735f, sign[2] * 0.57735f };
+        for (int i = 0; i < 3; ++i)
+        {
+            const float* corner = corners[flip ? 2 - i : i];
+            indices.push_back((GLuint)(vertices.size() / 6));
+            vertices.insert(vertices.end(), corner, corner + 3);
+            vertices.insert(vertices.end(), normal, normal + 3);
+        }
+    }
+    return pool.add(vertices.data(), vertices.size() / 6, indices.data(), indices.size());
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
@@ -0,0 +1,534 @@
+//
+//  main.cpp
+//  DrawBenchmark
+//
+//  Created by William Kpabitey Kwabla on 11/9/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+/*
+   Draw-call throughput benchmark. Draws a grid of N quads (N = 1, 10, ... up to 1M) with each
+   of the submission strategies the other projects use, plus the ones they could use:
+
+       naive        one glDrawElements per quad, its position set with glUniform2f
+       elements16   all quads baked into one vertex buffer, drawn in chunks of 16384 quads
+                    with 16-bit indices and glDrawElementsBaseVertex
+       elements32   the same chunks with 32-bit indices, so only the index width differs
+       instanced    one quad, per-instance offsets, a single glDrawElementsInstanced
+       multidraw    the baked buffer, one glMultiDrawElementsBaseVertex with a sub-draw per quad
+
+   For every strategy and count it records CPU submission time and GPU time (p50/p95, from the
+   profiler's timer queries) and frames per second, and writes them to CSV and JSON:
+
+       DrawBenchmark [--max N] [--frames F] [--budget MS] [--csv path] [--json path]
+
+   A strategy stops scaling up once its next count would take longer than --budget ms per
+   frame. Build with -DHEADLESS to run it without a display.
+ */
+
+// Standard C++ libraries
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// quads per chunk: 4 vertices each, so 65536 vertices, the most 16-bit indices can address
+const unsigned int CHUNK_QUADS = 16384;
+const int WARMUP_FRAMES = 5;
+
+const char *vertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec2 aPos;\n"
+"layout (location = 1) in vec2 aOffset;\n"
+"uniform float uScale;\n"
+"uniform vec2 uOffset;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = vec4(aPos * uScale + aOffset + uOffset, 0.0, 1.0);\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
+"}\n\0";
+
+enum Strategy { NAIVE, ELEMENTS16, ELEMENTS32, INSTANCED, MULTIDRAW, STRATEGY_COUNT };
+const char *strategyNames[STRATEGY_COUNT] = { "naive", "elements16", "elements32", "instanced", "multidraw" };
+
+
+// Everything one object count needs, for every strategy.
+struct Scene
+{
+    unsigned int count;
+    float scale;
+    std::vector<float> offsets;          // 2 floats per quad
+
+    GLuint quadVAO, instancedVAO, baked16VAO, baked32VAO;
+    GLuint quadVBO, quadEBO, offsetVBO, bakedVBO, chunk16EBO, chunk32EBO;
+
+    std::vector<GLsizei> counts;         // glMultiDrawElementsBaseVertex arguments
+    std::vector<const void*> indices;
+    std::vector<GLint> baseVertices;
+};
+
+struct Result
+{
+    Strategy strategy;
+    unsigned int objects;
+    unsigned int drawCalls;
+    int frames;
+    Profiler::Stats submit;
+    double fps;
+};
+
+
+// Function Prototypes
+unsigned int createProgram();
+Scene createScene(unsigned int count);
+void destroyScene(Scene &scene);
+unsigned int draw(const Scene &scene, Strategy strategy, GLint scaleLocation, GLint offsetLocation);
+Result measure(GLFWwindow *window, const Scene &scene, Strategy strategy, int frames, GLint scaleLocation, GLint offsetLocation);
+void writeCSV(const std::string &path, const std::vector<Result> &results);
+void writeJSON(const std::string &path, const std::vector<Result> &results);
+
+
+int main(int argc, char **argv) {
+
+    unsigned int maxObjects = 1000000;
+    int frames = 60;
+    double budget = 2000.0;
+    std::string csvPath = "draw-benchmark.csv";
+    std::string jsonPath = "draw-benchmark.json";
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--max") maxObjects = (unsigned int)std::strtoul(argv[i + 1], nullptr, 10);
+        else if (option == "--frames") frames = std::max(1, std::atoi(argv[i + 1]));
+        else if (option == "--budget") budget = std::atof(argv[i + 1]);
+        else if (option == "--csv") csvPath = argv[i + 1];
+        else if (option == "--json") jsonPath = argv[i + 1];
+        else
+        {
+            std::cout << "Unknown option " << option << std::endl;
+            return -1;
+        }
+    }
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Draw Benchmark", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    // measure the driver, not the display's refresh rate
+    glfwSwapInterval(0);
+
+    glewExperimental = GL_TRUE;
+    if(glewInit() != GLEW_OK) {
+        std::cout<< "Failed to initialize glew." <<std::endl;
+        return -1;
+    }
+
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    glViewport(0, 0, width, height);
+
+    unsigned int shaderProgram = createProgram();
+    if (shaderProgram == 0)
+    {
+        glfwTerminate();
+        return -1;
+    }
+    glUseProgram(shaderProgram);
+    GLint scaleLocation = glGetUniformLocation(shaderProgram, "uScale");
+    GLint offsetLocation = glGetUniformLocation(shaderProgram, "uOffset");
+
+    std::cout << "DRAW_BENCHMARK " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+
+    // the benchmark runs its own loop; this only marks where the render loop begins
+    glfwWindowShouldClose(window);
+
+    // 1, 10, 100, ... and finally --max itself
+    std::vector<unsigned int> objectCounts;
+    for (unsigned int count = 1; count < maxObjects; count *= 10)
+        objectCounts.push_back(count);
+    objectCounts.push_back(maxObjects);
+
+    std::vector<Result> results;
+    bool exhausted[STRATEGY_COUNT] = {};
+    bool aborted = false;
+    for (size_t c = 0; c < objectCounts.size() && !aborted; ++c)
+    {
+        unsigned int count = objectCounts[c];
+        Scene scene = createScene(count);
+        for (int strategy = 0; strategy < STRATEGY_COUNT && !aborted; ++strategy)
+        {
+            if (exhausted[strategy])
+                continue;
+            Result result = measure(window, scene, (Strategy)strategy, frames, scaleLocation, offsetLocation);
+            results.push_back(result);
+            std::cout << strategyNames[strategy] << " objects: " << count << " draws: " << result.drawCalls
+                      << " cpu p50: " << result.submit.cpu[0] << " ms gpu p50: " << result.submit.gpu[0]
+                      << " ms fps: " << result.fps << std::endl;
+
+            // assume cost grows linearly with the count and stop before a run would crawl
+            float frameTime = std::max(result.submit.cpu[0], result.submit.gpu[0]);
+            if ((double)frameTime * 10.0 > budget)
+            {
+                exhausted[strategy] = true;
+                std::cout << strategyNames[strategy] << " stops at " << count << " objects (over the " << budget << " ms budget)" << std::endl;
+            }
+            aborted = glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS;
+        }
+        destroyScene(scene);
+    }
+
+    writeCSV(csvPath, results);
+    writeJSON(jsonPath, results);
+    std::cout << "DRAW_BENCHMARK wrote " << results.size() << " results to " << csvPath << " and " << jsonPath << std::endl;
+
+    glDeleteProgram(shaderProgram);
+
+    glfwTerminate();
+    return 0;
+}
+
+
+unsigned int createProgram()
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(shaderProgram);
+        shaderProgram = 0;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+// lays the quads out on a square grid covering the viewport and builds every buffer up front,
+// so only submission is timed
+// ---------------------------------------------------------------------------------------------
+Scene createScene(unsigned int count)
+{
+    Scene scene;
+    scene.count = count;
+
+    unsigned int side = (unsigned int)std::ceil(std::sqrt((double)count));
+    float cell = 2.0f / (float)side;
+    scene.scale = cell * 0.8f;
+    scene.offsets.resize((size_t)count * 2);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        scene.offsets[(size_t)i * 2 + 0] = -1.0f + cell * (float)(i % side) + cell * 0.1f;
+        scene.offsets[(size_t)i * 2 + 1] = -1.0f + cell * (float)(i / side) + cell * 0.1f;
+    }
+
+    const float quad[] = { 0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,  0.0f, 1.0f };
+    const GLuint quadIndices[] = { 0, 1, 2,  2, 3, 0 };
+
+    // every quad's corners, already scaled and moved into place
+    std::vector<float> baked((size_t)count * 8);
+    for (unsigned int i = 0; i < count; ++i)
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            baked[(size_t)i * 8 + corner * 2 + 0] = quad[corner * 2 + 0] * scene.scale + scene.offsets[(size_t)i * 2 + 0];
+            baked[(size_t)i * 8 + corner * 2 + 1] = quad[corner * 2 + 1] * scene.scale + scene.offsets[(size_t)i * 2 + 1];
+        }
+
+    // one chunk's indices; every chunk reuses them through its base vertex
+    unsigned int chunkQuads = std::min(count, CHUNK_QUADS);
+    std::vector<GLushort> chunk16((size_t)chunkQuads * 6);
+    std::vector<GLuint> chunk32((size_t)chunkQuads * 6);
+    for (unsigned int i = 0; i < chunkQuads * 6; ++i)
+    {
+        chunk32[i] = (i / 6) * 4 + quadIndices[i % 6];
+        chunk16[i] = (GLushort)chunk32[i];
+    }
+
+    glGenVertexArrays(1, &scene.quadVAO);
+    glGenVertexArrays(1, &scene.instancedVAO);
+    glGenVertexArrays(1, &scene.baked16VAO);
+    glGenVertexArrays(1, &scene.baked32VAO);
+    glGenBuffers(1, &scene.quadVBO);
+    glGenBuffers(1, &scene.quadEBO);
+    glGenBuffers(1, &scene.offsetVBO);
+    glGenBuffers(1, &scene.bakedVBO);
+    glGenBuffers(1, &scene.chunk16EBO);
+    glGenBuffers(1, &scene.chunk32EBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, scene.quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.offsetVBO);
+    glBufferData(GL_ARRAY_BUFFER, scene.offsets.size() * sizeof(float), scene.offsets.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.bakedVBO);
+    glBufferData(GL_ARRAY_BUFFER, baked.size() * sizeof(float), baked.data(), GL_STATIC_DRAW);
+
+    // naive: the unit quad, positioned per draw by uOffset
+    glBindVertexArray(scene.quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.quadVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.quadEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), quadIndices, GL_STATIC_DRAW);
+
+    // instanced: the unit quad, positioned per instance by aOffset
+    glBindVertexArray(scene.instancedVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.quadVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.offsetVBO);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.quadEBO);
+
+    // elements16/32 and multidraw: the baked quads
+    glBindVertexArray(scene.baked16VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.bakedVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.chunk16EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, chunk16.size() * sizeof(GLushort), chunk16.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(scene.baked32VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.bakedVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.chunk32EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, chunk32.size() * sizeof(GLuint), chunk32.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+
+    scene.counts.assign(count, 6);
+    scene.indices.assign(count, (const void*)0);
+    scene.baseVertices.resize(count);
+    for (unsigned int i = 0; i < count; ++i)
+        scene.baseVertices[i] = (GLint)(i * 4);
+
+    return scene;
+}
+
+
+void destroyScene(Scene &scene)
+{
+    GLuint arrays[] = { scene.quadVAO, scene.instancedVAO, scene.baked16VAO, scene.baked32VAO };
+    GLuint buffers[] = { scene.quadVBO, scene.quadEBO, scene.offsetVBO, scene.bakedVBO, scene.chunk16EBO, scene.chunk32EBO };
+    glDeleteVertexArrays(4, arrays);
+    glDeleteBuffers(6, buffers);
+}
+
+
+// submits one frame's worth of quads and returns the number of draw calls it took
+// ---------------------------------------------------------------------------------------------
+unsigned int draw(const Scene &scene, Strategy strategy, GLint scaleLocation, GLint offsetLocation)
+{
+    unsigned int drawCalls = 0;
+    switch (strategy)
+    {
+        case NAIVE:
+            glBindVertexArray(scene.quadVAO);
+            glVertexAttrib2f(1, 0.0f, 0.0f);
+            glUniform1f(scaleLocation, scene.scale);
+            for (unsigned int i = 0; i < scene.count; ++i)
+            {
+                glUniform2f(offsetLocation, scene.offsets[(size_t)i * 2 + 0], scene.offsets[(size_t)i * 2 + 1]);
+                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            }
+            drawCalls = scene.count;
+            break;
+
+        case ELEMENTS16:
+        case ELEMENTS32:
+            glBindVertexArray(strategy == ELEMENTS16 ? scene.baked16VAO : scene.baked32VAO);
+            glVertexAttrib2f(1, 0.0f, 0.0f);
+            glUniform1f(scaleLocation, 1.0f);
+            glUniform2f(offsetLocation, 0.0f, 0.0f);
+            for (unsigned int first = 0; first < scene.count; first += CHUNK_QUADS)
+            {
+                unsigned int quads = std::min(CHUNK_QUADS, scene.count - first);
+                glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)(quads * 6), strategy == ELEMENTS16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, 0, (GLint)(first * 4));
+                ++drawCalls;
+            }
+            break;
+
+        case INSTANCED:
+            glBindVertexArray(scene.instancedVAO);
+            glUniform1f(scaleLocation, scene.scale);
+            glUniform2f(offsetLocation, 0.0f, 0.0f);
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)scene.count);
+            drawCalls = 1;
+            break;
+
+        case MULTIDRAW:
+            glBindVertexArray(scene.baked32VAO);
+            glVertexAttrib2f(1, 0.0f, 0.0f);
+            glUniform1f(scaleLocation, 1.0f);
+            glUniform2f(offsetLocation, 0.0f, 0.0f);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, scene.counts.data(), GL_UNSIGNED_INT, scene.indices.data(), (GLsizei)scene.count, const_cast<GLint*>(scene.baseVertices.data()));
+            drawCalls = 1;
+            break;
+
+        default:
+            break;
+    }
+    return drawCalls;
+}
+
+
+Result measure(GLFWwindow *window, const Scene &scene, Strategy strategy, int frames, GLint scaleLocation, GLint offsetLocation)
+{
+    Result result;
+    result.strategy = strategy;
+    result.objects = scene.count;
+    result.frames = frames;
+
+    // let the driver settle (first-use validation, buffer uploads) before anything is timed
+    for (int i = 0; i < WARMUP_FRAMES; ++i)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        draw(scene, strategy, scaleLocation, offsetLocation);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    glFinish();
+
+    Profiler profiler;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        profiler.beginFrame();
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        profiler.begin("submit");
+        result.drawCalls = draw(scene, strategy, scaleLocation, offsetLocation);
+        profiler.end();
+
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+    profiler.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.submit = profiler.stats("submit");
+    result.fps = seconds > 0.0 ? (double)frames / seconds : 0.0;
+    return result;
+}
+
+
+void writeCSV(const std::string &path, const std::vector<Result> &results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::DRAW_BENCHMARK::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+    file << "strategy,objects,draw_calls,frames,cpu_p50_ms,cpu_p95_ms,gpu_p50_ms,gpu_p95_ms,fps\n";
+    for (const Result &result : results)
+        file << strategyNames[result.strategy] << "," << result.objects << "," << result.drawCalls << "," << result.frames << ","
+             << result.submit.cpu[0] << "," << result.submit.cpu[1] << ","
+             << result.submit.gpu[0] << "," << result.submit.gpu[1] << "," << result.fps << "\n";
+}
+
+
+void writeJSON(const std::string &path, const std::vector<Result> &results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::DRAW_BENCHMARK::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+    // driver strings are the only free text; keep them valid JSON strings
+    auto quoted = [](const GLubyte *text) {
+        std::string result = "\"";
+        for (const char *c = reinterpret_cast<const char *>(text); c != nullptr && *c != '\0'; ++c)
+            if (*c == '"' || *c == '\\')
+                result += std::string("\\") + *c;
+            else if ((unsigned char)*c >= 0x20)
+                result += *c;
+        return result + "\"";
+    };
+    file << "{\n";
+    file << "  \"renderer\": " << quoted(glGetString(GL_RENDERER)) << ",\n";
+    file << "  \"version\": " << quoted(glGetString(GL_VERSION)) << ",\n";
+    file << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result &result = results[i];
+        file << "    {\"strategy\": \"" << strategyNames[result.strategy] << "\", \"objects\": " << result.objects
+             << ", \"draw_calls\": " << result.drawCalls << ", \"frames\": " << result.frames
+             << ", \"cpu_p50_ms\": " << result.submit.cpu[0] << ", \"cpu_p95_ms\": " << result.submit.cpu[1]
+             << ", \"gpu_p50_ms\": " << result.submit.gpu[0] << ", \"gpu_p95_ms\": " << result.submit.gpu[1]
+             << ", \"fps\": " << result.fps << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+}
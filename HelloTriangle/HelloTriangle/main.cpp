@@ -15,11 +15,19 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include "shader/shader.h"
+#include "shader/shaderReloader.h"
+#include "../../OpenGL/OpenGL/src/StateCache.h"
 #include <string>
 #else
 #include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
 #include <GLFW/glfw3.h>
+#endif
 #include "shader/shader.h"
+#include "shader/shaderReloader.h"
+#include "../../OpenGL/OpenGL/src/StateCache.h"
 #include <string>
 #endif
 
@@ -75,9 +83,27 @@ int main() {
     
     
     
-    // build and compile our shader program
+    // build and compile our shader program, reusing the linked binary from earlier runs when possible
     // ------------------------------------
-    Shader ourShader("/Users/william/Documents/Personal/OpenGL/HelloTriangle/HelloTriangle/shader/shader.vs", "/Users/william/Documents/Personal/OpenGL/HelloTriangle/HelloTriangle/shader/shader.fs");
+    // the shader files sit next to this source file, wherever the checkout is (e.g. on a headless build machine)
+    const std::string sourceDirectory = std::string(__FILE__).substr(0, std::string(__FILE__).rfind('/') + 1);
+    const std::string vertexFile = sourceDirectory + "shader/shader.vs";
+    const std::string fragmentFile = sourceDirectory + "shader/shader.fs";
+    const char* vertexPath = vertexFile.c_str();
+    const char* fragmentPath = fragmentFile.c_str();
+    ProgramCache programCache("shader-cache");
+    Shader ourShader(vertexPath, fragmentPath, nullptr, &programCache);
+    programCache.printStats();
+    
+    StateCache state;
+
+    // rebuild the program in the background whenever shader.vs or shader.fs is saved
+    ShaderReloader reloader;
+    reloader.watch("ourShader", {{vertexPath, GL_VERTEX_SHADER}, {fragmentPath, GL_FRAGMENT_SHADER}}, [&](GLuint program) {
+        ourShader.adopt(program);
+        // the old program is deleted and its name may be handed out again
+        state.invalidate();
+    });
    
     
     float vertices[] = {
@@ -113,6 +139,10 @@ int main() {
         
        /* Process input */
         processInput(window);
+        state.beginFrame();
+        
+        /* Swap in any shader that finished reloading since the last frame */
+        reloader.update();
         
          /* Render here */
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -120,9 +150,9 @@ int main() {
         
         
         // draw our first triangle
-        ourShader.use();
+        state.useProgram(ourShader.ID);
         
-        glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
+        state.bindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
         glDrawArrays(GL_TRIANGLES, 0, 3);
         
 
@@ -133,6 +163,7 @@ int main() {
         glfwPollEvents();
     }
 
+    state.printStats();
     
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
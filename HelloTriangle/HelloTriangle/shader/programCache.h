@@ -0,0 +1,274 @@
+//
+//  programCache.h
+//  HelloTriangle
+//
+//  Created by William Kpabitey Kwabla on 11/6/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+
+#include <GL/glew.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include <initializer_list>
+#include <cstdint>
+#include <cstdio>
+#include <sys/stat.h>
+
+// Stores linked programs on disk with glGetProgramBinary so later launches can skip compiling
+// and linking GLSL. Entries are keyed by a hash of every stage source plus the driver's
+// vendor/renderer/version strings, since a binary is only valid for the driver that made it.
+class ProgramCache
+{
+public:
+    // one shader stage as the pointer/length pairs glShaderSource takes. The text itself is
+    // not owned; it may be split over several pieces (e.g. a memory-mapped file and its includes).
+    struct Stage
+    {
+        GLenum type;
+        std::vector<const GLchar*> strings;
+        std::vector<GLint> lengths;
+
+        explicit Stage(GLenum type) : type(type) {}
+        Stage(GLenum type, std::string_view source) : type(type)
+        {
+            append(source);
+        }
+        void append(std::string_view piece)
+        {
+            if (piece.empty())
+                return;
+            strings.push_back(piece.data());
+            lengths.push_back((GLint)piece.size());
+        }
+        size_t size() const
+        {
+            size_t total = 0;
+            for (GLint length : lengths)
+                total += (size_t)length;
+            return total;
+        }
+    };
+    // compiles, attaches and links the stages into the program it is given
+    using BuildFunction = std::function<void(GLuint program)>;
+
+    explicit ProgramCache(std::string directory) : directory(std::move(directory))
+    {
+        mkdir(this->directory.c_str(), 0755);
+    }
+
+    // returns a linked program, from the cache when possible. On a miss (or when the driver
+    // rejects the cached binary) the program is built from source and written back.
+    // ------------------------------------------------------------------------
+    GLuint load(std::initializer_list<Stage> stages, const BuildFunction &build)
+    {
+        return load(stages.begin(), stages.end(), build);
+    }
+    GLuint load(const std::vector<Stage> &stages, const BuildFunction &build)
+    {
+        return load(stages.data(), stages.data() + stages.size(), build);
+    }
+
+    // the pieces of load() for callers that build programs themselves (e.g. asynchronously):
+    // find() returns 0 on a miss, prepare() must run before glLinkProgram, and store() saves
+    // the program once it has linked. Keys let the sources be released in between.
+    // ------------------------------------------------------------------------
+    std::uint64_t key(const std::vector<Stage> &stages) const
+    {
+        return hashKey(stages.data(), stages.data() + stages.size());
+    }
+    GLuint find(std::uint64_t key)
+    {
+        if (!supported())
+        {
+            ++missCount;
+            return 0;
+        }
+        GLuint program = glCreateProgram();
+        if (loadBinary(program, pathFor(key), key))
+        {
+            ++hitCount;
+            return program;
+        }
+        // a program that failed glProgramBinary cannot be reused for a source build
+        glDeleteProgram(program);
+        ++missCount;
+        return 0;
+    }
+    void prepare(GLuint program)
+    {
+        if (supported())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    void store(std::uint64_t key, GLuint program)
+    {
+        if (!supported())
+            return;
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked)
+            saveBinary(program, pathFor(key), key);
+    }
+
+    unsigned int hits() const { return hitCount; }
+    unsigned int misses() const { return missCount; }
+    unsigned int rejected() const { return rejectCount; }
+
+    void printStats() const
+    {
+        std::cout << "SHADER::PROGRAM_CACHE hits: " << hitCount << " misses: " << missCount << " (rejected binaries: " << rejectCount << ")" << std::endl;
+    }
+
+private:
+    static constexpr std::uint32_t MAGIC = 0x42504c47; // "GLPB"
+    static constexpr std::uint32_t VERSION = 1;
+
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t key;
+        std::uint32_t format;
+        std::uint32_t length;
+    };
+
+    std::string directory;
+    unsigned int hitCount = 0;
+    unsigned int missCount = 0;
+    unsigned int rejectCount = 0;
+    int binarySupport = -1;
+
+    GLuint load(const Stage *first, const Stage *last, const BuildFunction &build)
+    {
+        std::uint64_t programKey = hashKey(first, last);
+        if (GLuint program = find(programKey))
+            return program;
+
+        GLuint program = glCreateProgram();
+        prepare(program);
+        build(program);
+        store(programKey, program);
+        return program;
+    }
+
+    // glProgramBinary is core in 4.1; older contexts need the extension, and drivers may
+    // still advertise zero binary formats.
+    // ------------------------------------------------------------------------
+    bool supported()
+    {
+        if (binarySupport < 0)
+        {
+            GLint formats = 0;
+            if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            binarySupport = formats > 0;
+        }
+        return binarySupport != 0;
+    }
+
+    static void fnv1a(std::uint64_t &hash, const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    static std::uint64_t hashKey(const Stage *first, const Stage *last)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            const char *value = reinterpret_cast<const char *>(glGetString(name));
+            std::string_view text = value ? value : "";
+            fnv1a(hash, text.data(), text.size() + (value ? 1 : 0));
+        }
+        for (const Stage *stage = first; stage != last; ++stage)
+        {
+            // hashed as one continuous text, so how it is split into pieces does not matter
+            std::uint64_t size = stage->size();
+            fnv1a(hash, &stage->type, sizeof(stage->type));
+            fnv1a(hash, &size, sizeof(size));
+            for (size_t piece = 0; piece < stage->strings.size(); ++piece)
+                fnv1a(hash, stage->strings[piece], (size_t)stage->lengths[piece]);
+        }
+        return hash;
+    }
+
+    std::string pathFor(std::uint64_t key) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return directory + "/" + name;
+    }
+
+    bool loadBinary(GLuint program, const std::string &path, std::uint64_t key)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        Header header{};
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            header.magic != MAGIC || header.version != VERSION || header.key != key)
+            return false;
+        std::vector<char> binary(header.length);
+        if (!file.read(binary.data(), binary.size()))
+            return false;
+
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            // driver update or foreign binary; rebuilding from source overwrites the entry
+            ++rejectCount;
+            return false;
+        }
+        return true;
+    }
+
+    void saveBinary(GLuint program, const std::string &path, std::uint64_t key)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        Header header{MAGIC, VERSION, key, format, (std::uint32_t)length};
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(binary.data(), length);
+            file.close();
+            if (!file)
+            {
+                std::cout << "ERROR::SHADER::PROGRAM_CACHE::WRITE_FAILED " << temporary << std::endl;
+                std::remove(temporary.c_str());
+                return;
+            }
+        }
+        // rename is atomic, so a crash never leaves a half-written entry behind
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::cout << "ERROR::SHADER::PROGRAM_CACHE::WRITE_FAILED " << path << std::endl;
+            std::remove(temporary.c_str());
+        }
+    }
+};
+
+
+#endif /* programCache_h */
@@ -13,97 +13,89 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "programCache.h"
+#include "shaderSource.h"
+
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <string_view>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
 class Shader
 {
 public:
+    // uniforms are addressed by a 32-bit FNV-1a hash of their name so the setters never
+    // have to build a std::string or ask the driver for a location.
+    // ------------------------------------------------------------------------
+    struct UniformID
+    {
+        std::uint32_t hash;
+        constexpr explicit UniformID(std::string_view name) : hash(fnv1a(name)) {}
+    };
+    static constexpr std::uint32_t fnv1a(std::string_view name)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (char c : name)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
     unsigned int ID;
-    // constructor generates the shader on the fly
-    // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
-    {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try
+    // constructor generates the shader on the fly; when a cache is given the linked program
+    // is fetched from (or stored to) disk instead of always compiling from source
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, ProgramCache* cache = nullptr)
+    {
+        // 1. map the vertex/fragment (and geometry) files; the stages point straight into them
+        ShaderSource source;
+        source.load(vertexPath, GL_VERTEX_SHADER);
+        source.load(fragmentPath, GL_FRAGMENT_SHADER);
+        // if geometry shader path is present, also load a geometry shader
+        if(geometryPath != nullptr)
+            source.load(geometryPath, GL_GEOMETRY_SHADER);
+        // 2. compile shaders and link them into the program handed to us
+        auto build = [&](GLuint program)
         {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
+            std::vector<unsigned int> shaders;
+            for(const ProgramCache::Stage& stage : source.stages())
             {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
+                unsigned int shader = glCreateShader(stage.type);
+                glShaderSource(shader, (GLsizei)stage.strings.size(), stage.strings.data(), stage.lengths.data());
+                glCompileShader(shader);
+                glAttachShader(program, shader);
+                shaders.push_back(shader);
             }
-        }
-        catch (std::ifstream::failure e)
+            glLinkProgram(program);
+            // stage status is only read once the link has failed: querying it straight after each
+            // glCompileShader would make us wait for every stage in turn
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            if(!linked)
+            {
+                for(size_t i = 0; i < shaders.size(); ++i)
+                    checkCompileErrors(shaders[i], ShaderSource::stageName(source.stages()[i].type));
+                checkCompileErrors(program, "PROGRAM");
+            }
+            // delete the shaders as they're linked into our program now and no longer necessery
+            for(unsigned int shader : shaders)
+                glDeleteShader(shader);
+        };
+        if(cache != nullptr)
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+            ID = cache->load(source.stages(), build);
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
+        else
         {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            ID = glCreateProgram();
+            build(ID);
         }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+        // 3. cache every active uniform location once, right after link
+        reflectUniforms();
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -111,66 +103,183 @@ public:
     {
         glUseProgram(ID);
     }
+    // take over an already linked program (e.g. a hot-reloaded one) in place of the current one
+    // ------------------------------------------------------------------------
+    void adopt(unsigned int program)
+    {
+        glDeleteProgram(ID);
+        ID = program;
+        reflectUniforms();
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(UniformID id, bool value) const
+    {
+        glUniform1i(location(id), (int)value);
+    }
+    void setBool(std::string_view name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        setBool(UniformID(name), value);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(UniformID id, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(location(id), value);
+    }
+    void setInt(std::string_view name, int value) const
+    {
+        setInt(UniformID(name), value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(UniformID id, float value) const
+    {
+        glUniform1f(location(id), value);
+    }
+    void setFloat(std::string_view name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        setFloat(UniformID(name), value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(UniformID id, const glm::vec2 &value) const
+    {
+        glUniform2fv(location(id), 1, &value[0]);
+    }
+    void setVec2(std::string_view name, const glm::vec2 &value) const
+    {
+        setVec2(UniformID(name), value);
+    }
+    void setVec2(UniformID id, float x, float y) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform2f(location(id), x, y);
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(std::string_view name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        setVec2(UniformID(name), x, y);
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(UniformID id, const glm::vec3 &value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(location(id), 1, &value[0]);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(std::string_view name, const glm::vec3 &value) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        setVec3(UniformID(name), value);
+    }
+    void setVec3(UniformID id, float x, float y, float z) const
+    {
+        glUniform3f(location(id), x, y, z);
+    }
+    void setVec3(std::string_view name, float x, float y, float z) const
+    {
+        setVec3(UniformID(name), x, y, z);
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(UniformID id, const glm::vec4 &value) const
+    {
+        glUniform4fv(location(id), 1, &value[0]);
+    }
+    void setVec4(std::string_view name, const glm::vec4 &value) const
+    {
+        setVec4(UniformID(name), value);
+    }
+    void setVec4(UniformID id, float x, float y, float z, float w) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4f(location(id), x, y, z, w);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w)
+    void setVec4(std::string_view name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        setVec4(UniformID(name), x, y, z, w);
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(UniformID id, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(id), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat2(std::string_view name, const glm::mat2 &mat) const
+    {
+        setMat2(UniformID(name), mat);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(UniformID id, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(location(id), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat3(std::string_view name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(UniformID(name), mat);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(UniformID id, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(id), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(std::string_view name, const glm::mat4 &mat) const
+    {
+        setMat4(UniformID(name), mat);
+    }
+    // ------------------------------------------------------------------------
+    // looks a uniform up in the table built at link time; -1 (a no-op for glUniform*) if the
+    // program has no active uniform of that name.
+    GLint location(UniformID id) const
+    {
+        auto it = std::lower_bound(uniforms.begin(), uniforms.end(), id.hash,
+                                   [](const Uniform &u, std::uint32_t hash) { return u.hash < hash; });
+        return (it != uniforms.end() && it->hash == id.hash) ? it->location : -1;
+    }
+    GLint location(std::string_view name) const
+    {
+        return location(UniformID(name));
     }
 
 private:
+    // one entry per addressable uniform, sorted by hash so lookups are a binary search over
+    // a single contiguous array.
+    struct Uniform
+    {
+        std::uint32_t hash;
+        GLint location;
+    };
+    std::vector<Uniform> uniforms;
+
+    // walks the active uniforms of the linked program and records their locations. Arrays are
+    // registered under their bare name, "name[0]" and every "name[i]" element.
+    // ------------------------------------------------------------------------
+    void reflectUniforms()
+    {
+        uniforms.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> name(maxLength > 0 ? maxLength + 16 : 16);
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &size, &type, name.data());
+            GLint base = glGetUniformLocation(ID, name.data());
+            if (base < 0)
+                continue; // uniform block members have no location
+            std::string_view full(name.data(), (size_t)length);
+            std::string_view bare = full.substr(0, full.find('['));
+            uniforms.push_back({fnv1a(full), base});
+            if (bare.size() != full.size())
+                uniforms.push_back({fnv1a(bare), base});
+            for (GLint element = 1; element < size; ++element)
+            {
+                std::string indexed = std::string(bare) + "[" + std::to_string(element) + "]";
+                uniforms.push_back({fnv1a(indexed), glGetUniformLocation(ID, indexed.c_str())});
+            }
+        }
+        std::sort(uniforms.begin(), uniforms.end(),
+                  [](const Uniform &a, const Uniform &b) { return a.hash < b.hash; });
+        for (size_t i = 1; i < uniforms.size(); ++i)
+        {
+            if (uniforms[i].hash == uniforms[i - 1].hash && uniforms[i].location != uniforms[i - 1].location)
+                std::cout << "WARNING::SHADER::UNIFORM_HASH_COLLISION between locations " << uniforms[i - 1].location << " and " << uniforms[i].location << std::endl;
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,236 @@
+//
+//  shaderCompiler.h
+//  HelloTriangle
+//
+//  Created by William Kpabitey Kwabla on 11/6/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+
+#include <GL/glew.h>
+
+#include "programCache.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+// Batch shader compiler. Every stage of every program is handed to the driver in one go and
+// the status checks are deferred to poll(), which the render loop calls once per frame.
+// With GL_KHR_parallel_shader_compile (or the ARB version) the driver compiles on its own
+// threads and poll() only reads GL_COMPLETION_STATUS, so nothing ever waits on the compiler.
+// Handles stay valid until remove(), after which add() hands them out again.
+class ShaderCompiler
+{
+public:
+    enum class Status { Queued, Compiling, Ready, Failed };
+    using Handle = size_t;
+
+    explicit ShaderCompiler(ProgramCache* cache = nullptr) : cache(cache)
+    {
+        // let the driver use as many compiler threads as it likes
+        if (GLEW_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else if (GLEW_ARB_parallel_shader_compile)
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+    ~ShaderCompiler()
+    {
+        for (Program &program : programs)
+        {
+            if (program.removed || program.status == Status::Ready)
+                continue; // linked programs belong to the caller
+            release(program);
+            if (program.id != 0)
+                glDeleteProgram(program.id);
+        }
+    }
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+    static bool parallel()
+    {
+        return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+    }
+
+    // queues a program. The text the stages point at only has to stay alive until submit()
+    // returns, because glShaderSource copies it. A program found in the cache is ready immediately.
+    // ------------------------------------------------------------------------
+    Handle add(std::string name, std::vector<ProgramCache::Stage> stages)
+    {
+        Handle handle = programs.size();
+        if (!unused.empty())
+        {
+            handle = unused.back();
+            unused.pop_back();
+        }
+        Program program;
+        program.name = std::move(name);
+        if (cache != nullptr)
+        {
+            program.key = cache->key(stages);
+            program.id = cache->find(program.key);
+        }
+        if (program.id != 0)
+            program.status = Status::Ready;
+        else
+            program.stages = std::move(stages);
+        if (handle == programs.size())
+            programs.push_back(std::move(program));
+        else
+            programs[handle] = std::move(program);
+        return handle;
+    }
+
+    // forgets a program. One that is still queued or compiling is deleted; a linked one now
+    // belongs to the caller alone.
+    // ------------------------------------------------------------------------
+    void remove(Handle handle)
+    {
+        Program &program = programs[handle];
+        if (program.removed)
+            return;
+        release(program);
+        if (program.id != 0 && program.status != Status::Ready)
+            glDeleteProgram(program.id);
+        program = Program();
+        program.removed = true;
+        unused.push_back(handle);
+    }
+
+    // starts compiling every queued stage, then links every queued program. No status is
+    // read here; the driver is free to work on all of them at once.
+    // ------------------------------------------------------------------------
+    void submit()
+    {
+        for (Program &program : programs)
+        {
+            if (program.removed || program.status != Status::Queued)
+                continue;
+            for (const ProgramCache::Stage &stage : program.stages)
+            {
+                GLuint shader = glCreateShader(stage.type);
+                glShaderSource(shader, (GLsizei)stage.strings.size(), stage.strings.data(), stage.lengths.data());
+                glCompileShader(shader);
+                program.shaders.push_back(shader);
+            }
+        }
+        for (Program &program : programs)
+        {
+            if (program.removed || program.status != Status::Queued)
+                continue;
+            program.id = glCreateProgram();
+            if (cache != nullptr)
+                cache->prepare(program.id);
+            for (GLuint shader : program.shaders)
+                glAttachShader(program.id, shader);
+            glLinkProgram(program.id);
+            program.status = Status::Compiling;
+            program.stages.clear();
+        }
+    }
+
+    // checks the programs that are still compiling. Returns true when at least one of them
+    // finished (successfully or not) during this call.
+    // ------------------------------------------------------------------------
+    bool poll()
+    {
+        bool changed = false;
+        for (Program &program : programs)
+        {
+            if (program.status != Status::Compiling)
+                continue;
+            if (parallel())
+            {
+                GLint complete = GL_FALSE;
+                glGetProgramiv(program.id, GL_COMPLETION_STATUS_KHR, &complete);
+                if (!complete)
+                    continue;
+            }
+            finish(program);
+            changed = true;
+            // without the extension, reading the link status blocks until the program is
+            // done, so only resolve one program per frame to spread the stall out
+            if (!parallel())
+                break;
+        }
+        return changed;
+    }
+
+    Status status(Handle handle) const { return programs[handle].status; }
+    // the linked program, or 0 while it is still compiling or if it failed
+    GLuint program(Handle handle) const
+    {
+        return programs[handle].status == Status::Ready ? programs[handle].id : 0;
+    }
+    size_t pending() const
+    {
+        size_t count = 0;
+        for (const Program &program : programs)
+            count += !program.removed && (program.status == Status::Queued || program.status == Status::Compiling);
+        return count;
+    }
+
+private:
+    struct Program
+    {
+        std::string name;
+        std::vector<ProgramCache::Stage> stages;
+        std::vector<GLuint> shaders;
+        std::uint64_t key = 0;
+        GLuint id = 0;
+        Status status = Status::Queued;
+        bool removed = false;
+    };
+
+    ProgramCache* cache;
+    std::vector<Program> programs;
+    std::vector<Handle> unused;     // removed, for add() to reuse
+
+    void finish(Program &program)
+    {
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program.id, GL_LINK_STATUS, &linked);
+        if (linked)
+        {
+            program.status = Status::Ready;
+            if (cache != nullptr)
+                cache->store(program.key, program.id);
+        }
+        else
+        {
+            // only now is it worth asking which stage broke
+            GLchar infoLog[1024];
+            for (GLuint shader : program.shaders)
+            {
+                GLint compiled = GL_FALSE;
+                glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+                if (!compiled)
+                {
+                    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                    std::cout << "ERROR::SHADER_COMPILATION_ERROR in program: " << program.name << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                }
+            }
+            glGetProgramInfoLog(program.id, 1024, NULL, infoLog);
+            std::cout << "ERROR::PROGRAM_LINKING_ERROR in program: " << program.name << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            glDeleteProgram(program.id);
+            program.id = 0;
+            program.status = Status::Failed;
+        }
+        release(program);
+    }
+
+    void release(Program &program)
+    {
+        for (GLuint shader : program.shaders)
+            glDeleteShader(shader);
+        program.shaders.clear();
+    }
+};
+
+
+#endif /* shaderCompiler_h */
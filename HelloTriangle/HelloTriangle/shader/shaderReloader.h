@@ -0,0 +1,293 @@
+//
+//  shaderReloader.h
+//  HelloTriangle
+//
+//  Created by William Kpabitey Kwabla on 11/6/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+
+#include <GL/glew.h>
+
+#include "shaderSource.h"
+#include "shaderCompiler.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// Hot-reloads shader programs while the render loop keeps running. A background thread
+// watches every file a program was built from (inotify on Linux, mtime polling elsewhere),
+// re-parses changed programs off the render thread, and hands the new sources to update().
+// update() runs on the GL thread at a frame boundary: it submits the sources to a
+// ShaderCompiler, and once a replacement has linked, passes it to the program's callback so
+// it is swapped in between frames. A replacement that fails to build is reported and
+// dropped; the last good program stays bound. While a program compiles, later edits wait:
+// only the newest is kept, and it starts once the compile in flight is done, whose result
+// is then thrown away rather than swapped in.
+class ShaderReloader
+{
+public:
+    // a file and the stage it holds, or GL_NONE for a file with "#shader" sections
+    struct File
+    {
+        std::string path;
+        GLenum type;
+    };
+    // receives a freshly linked program; the callee owns it and the one it replaces
+    using SwapFunction = std::function<void(GLuint program)>;
+
+    ShaderReloader() : worker([this] { run(); }) {}
+    ~ShaderReloader()
+    {
+        running = false;
+        worker.join();
+#ifdef __linux__
+        if (notify >= 0)
+            close(notify);
+#endif
+    }
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    void watch(std::string name, std::vector<File> files, SwapFunction swap)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Program program;
+        program.name = std::move(name);
+        program.files = std::move(files);
+        program.swap = std::move(swap);
+        programs.push_back(std::move(program));
+        rescan.push_back(programs.size() - 1);
+    }
+
+    // call once per frame, before drawing, on the thread that owns the GL context
+    // ------------------------------------------------------------------------
+    void update()
+    {
+        std::vector<Parsed> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(parsed);
+        }
+        for (Parsed &result : ready)
+            programs[result.program].next = std::move(result.source);
+
+        compiler.poll();
+        for (Program &program : programs)
+        {
+            if (!program.compiling)
+                continue;
+            ShaderCompiler::Status status = compiler.status(program.compile);
+            if (status == ShaderCompiler::Status::Ready && program.next != nullptr)
+            {
+                // already out of date: a newer edit is waiting to be built
+                glDeleteProgram(compiler.program(program.compile));
+            }
+            else if (status == ShaderCompiler::Status::Ready)
+            {
+                std::cout << "SHADER::RELOADED " << program.name << std::endl;
+                program.swap(compiler.program(program.compile));
+            }
+            else if (status == ShaderCompiler::Status::Failed)
+            {
+                std::cout << "SHADER::RELOAD_FAILED " << program.name << ", keeping the previous program" << std::endl;
+            }
+            else
+            {
+                continue;
+            }
+            compiler.remove(program.compile);
+            program.compiling = false;
+        }
+
+        // the sources only have to live until glShaderSource has copied them
+        std::vector<std::unique_ptr<ShaderSource>> submitted;
+        for (Program &program : programs)
+        {
+            if (program.compiling || program.next == nullptr)
+                continue;
+            program.compile = compiler.add(program.name, program.next->stages());
+            program.compiling = true;
+            submitted.push_back(std::move(program.next));
+        }
+        if (!submitted.empty())
+            compiler.submit();
+    }
+
+private:
+    struct Program
+    {
+        std::string name;
+        std::vector<File> files;
+        SwapFunction swap;
+        std::set<std::string> watched; // files plus everything they include
+        ShaderCompiler::Handle compile = 0;
+        bool compiling = false;
+        std::unique_ptr<ShaderSource> next; // the newest edit, waiting for compile to finish
+    };
+    struct Parsed
+    {
+        size_t program;
+        std::unique_ptr<ShaderSource> source;
+    };
+
+    std::mutex mutex;
+    std::vector<Program> programs;  // guarded by mutex, except the GL-thread-only members
+    std::vector<size_t> rescan;     // newly watched programs whose includes are not known yet
+    std::vector<Parsed> parsed;     // sources waiting for update()
+    ShaderCompiler compiler;
+    std::atomic<bool> running{true};
+    std::map<std::string, time_t> modified;
+#ifdef __linux__
+    int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    std::map<int, std::string> directories;
+#endif
+    std::thread worker;
+
+    std::unique_ptr<ShaderSource> parse(const std::vector<File> &files)
+    {
+        std::unique_ptr<ShaderSource> source(new ShaderSource());
+        for (const File &file : files)
+            if (!source->load(file.path, file.type))
+                return nullptr;
+        return source;
+    }
+
+    // the watcher thread: wait for changes, let the editor finish writing, re-parse
+    // ------------------------------------------------------------------------
+    void run()
+    {
+        while (running)
+        {
+            std::set<std::string> changed = waitForChanges();
+            if (changed.empty())
+                continue;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            std::set<std::string> more = waitForChanges();
+            changed.insert(more.begin(), more.end());
+
+            std::vector<std::pair<size_t, std::vector<File>>> dirty;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (size_t i = 0; i < programs.size(); ++i)
+                    for (const std::string &path : programs[i].watched)
+                        if (changed.count(path) != 0)
+                        {
+                            dirty.push_back({i, programs[i].files});
+                            break;
+                        }
+            }
+            // parse without holding the lock so update() never waits on the disk
+            for (auto &program : dirty)
+            {
+                std::unique_ptr<ShaderSource> source = parse(program.second);
+                if (source == nullptr)
+                    continue; // a half-saved or missing file; the next save tries again
+                std::lock_guard<std::mutex> lock(mutex);
+                track(programs[program.first], source->paths());
+                parsed.push_back({program.first, std::move(source)});
+            }
+        }
+    }
+
+    void track(Program &program, const std::vector<std::string> &paths)
+    {
+        for (const std::string &path : paths)
+        {
+            if (!program.watched.insert(path).second)
+                continue;
+            struct stat info;
+            modified[path] = stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+#ifdef __linux__
+            // editors often save by renaming a new file over the old one, so watch the directory
+            std::string directory = path.substr(0, path.rfind('/'));
+            bool known = false;
+            for (const auto &entry : directories)
+                known = known || entry.second == directory;
+            if (!known && notify >= 0)
+            {
+                int descriptor = inotify_add_watch(notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                if (descriptor >= 0)
+                    directories[descriptor] = directory;
+            }
+#endif
+        }
+    }
+
+    // blocks for up to a quarter of a second and returns the watched paths that changed
+    std::set<std::string> waitForChanges()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i : rescan)
+            {
+                // parsed once only to learn what the files include
+                std::vector<std::string> paths;
+                for (const File &file : programs[i].files)
+                    paths.push_back(ShaderSource::canonical(file.path));
+                std::unique_ptr<ShaderSource> source = parse(programs[i].files);
+                if (source != nullptr)
+                    paths = source->paths();
+                track(programs[i], paths);
+            }
+            rescan.clear();
+        }
+
+        std::set<std::string> changed;
+#ifdef __linux__
+        if (notify >= 0)
+        {
+            pollfd descriptor = {notify, POLLIN, 0};
+            if (::poll(&descriptor, 1, 250) <= 0)
+                return changed;
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(notify, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *at = buffer; at < buffer + length;)
+                {
+                    const inotify_event *event = reinterpret_cast<const inotify_event *>(at);
+                    auto directory = directories.find(event->wd);
+                    if (directory != directories.end() && event->len > 0)
+                        changed.insert(directory->second + "/" + event->name);
+                    at += sizeof(inotify_event) + event->len;
+                }
+            }
+            return changed;
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &entry : modified)
+        {
+            struct stat info;
+            if (stat(entry.first.c_str(), &info) == 0 && info.st_mtime != entry.second)
+            {
+                entry.second = info.st_mtime;
+                changed.insert(entry.first);
+            }
+        }
+        return changed;
+    }
+};
+
+
+#endif /* shaderReloader_h */
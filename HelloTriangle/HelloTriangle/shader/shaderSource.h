@@ -0,0 +1,281 @@
+//
+//  shaderSource.h
+//  HelloTriangle
+//
+//  Created by William Kpabitey Kwabla on 11/6/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+
+#include <GL/glew.h>
+
+#include "programCache.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <iostream>
+#include <cstring>
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// A read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                bytes = static_cast<const char *>(mapping);
+                length = (size_t)info.st_size;
+            }
+        }
+        else if (fstat(fd, &info) == 0)
+        {
+            empty = true; // mmap cannot map zero bytes, but an empty file is still a file
+        }
+        close(fd);
+    }
+    ~MappedFile()
+    {
+        if (bytes != nullptr)
+            munmap(const_cast<char *>(bytes), length);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool valid() const { return bytes != nullptr || empty; }
+    std::string_view text() const { return std::string_view(bytes != nullptr ? bytes : "", length); }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+    bool empty = false;
+};
+
+// Loads GLSL straight out of memory-mapped files. A file may hold several stages, each
+// starting at a "#shader vertex|fragment|geometry|compute" line; text before the first such
+// line is ignored, and a file without any is one stage of the type the caller names.
+// "#include" lines are resolved relative to the including file, every file is mapped once
+// per ShaderSource and pulled into a given stage at most once. Stages end up as
+// pointer/length pairs into the mappings, ready for glShaderSource, so no source text is
+// copied. Keep the ShaderSource alive until the shaders have been handed to the driver.
+class ShaderSource
+{
+public:
+    // returns false (after printing why) if the file or one of its includes cannot be read,
+    // or a "#shader" line names an unknown stage.
+    // Several files can be loaded into one ShaderSource; they share the include cache.
+    // ------------------------------------------------------------------------
+    bool load(const std::string &path, GLenum defaultType = GL_NONE)
+    {
+        std::string key = canonical(path);
+        const MappedFile *file = map(key);
+        if (file == nullptr)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+            return false;
+        }
+        current = -1;
+        implicitStage = defaultType != GL_NONE;
+        if (implicitStage)
+            begin(defaultType, file);
+        return scan(key, file, 0);
+    }
+
+    const std::vector<ProgramCache::Stage> &stages() const { return stageList; }
+    const ProgramCache::Stage *stage(GLenum type) const
+    {
+        for (const ProgramCache::Stage &stage : stageList)
+            if (stage.type == type)
+                return &stage;
+        return nullptr;
+    }
+    // every file the stages were built from, includes too
+    std::vector<std::string> paths() const
+    {
+        std::vector<std::string> result;
+        for (const auto &file : files)
+            result.push_back(file.first);
+        return result;
+    }
+
+    static const char *stageName(GLenum type)
+    {
+        switch (type)
+        {
+            case GL_VERTEX_SHADER: return "VERTEX";
+            case GL_FRAGMENT_SHADER: return "FRAGMENT";
+            case GL_GEOMETRY_SHADER: return "GEOMETRY";
+            case GL_COMPUTE_SHADER: return "COMPUTE";
+            default: return "UNKNOWN";
+        }
+    }
+
+    static std::string canonical(const std::string &path)
+    {
+        char resolved[PATH_MAX];
+        return realpath(path.c_str(), resolved) != nullptr ? std::string(resolved) : path;
+    }
+
+private:
+    static constexpr int MAX_INCLUDE_DEPTH = 32;
+
+    std::map<std::string, std::unique_ptr<MappedFile>> files;
+    std::vector<ProgramCache::Stage> stageList;
+    // stage being filled by the current load(), and the files already pulled into it
+    int current = -1;
+    bool implicitStage = false;
+    std::set<const MappedFile *> included;
+
+    const MappedFile *map(const std::string &key)
+    {
+        auto found = files.find(key);
+        if (found != files.end())
+            return found->second.get();
+        std::unique_ptr<MappedFile> file(new MappedFile(key));
+        if (!file->valid())
+            return nullptr;
+        return (files[key] = std::move(file)).get();
+    }
+
+    void begin(GLenum type, const MappedFile *file)
+    {
+        stageList.emplace_back(type);
+        current = (int)stageList.size() - 1;
+        included = {file};
+    }
+
+    // the keyword of a directive line such as "  #  include "x"", with its argument trimmed
+    static std::string_view directive(std::string_view line, std::string_view &argument)
+    {
+        size_t at = line.find_first_not_of(" \t");
+        if (at == std::string_view::npos || line[at] != '#')
+            return {};
+        at = line.find_first_not_of(" \t", at + 1);
+        if (at == std::string_view::npos)
+            return {};
+        size_t end = line.find_first_of(" \t\r\n", at);
+        std::string_view keyword = line.substr(at, end == std::string_view::npos ? std::string_view::npos : end - at);
+        argument = end == std::string_view::npos ? std::string_view() : line.substr(end);
+        size_t first = argument.find_first_not_of(" \t");
+        size_t last = argument.find_last_not_of(" \t\r\n");
+        argument = first == std::string_view::npos ? std::string_view() : argument.substr(first, last - first + 1);
+        return keyword;
+    }
+
+    static GLenum stageType(std::string_view name)
+    {
+        if (name == "vertex") return GL_VERTEX_SHADER;
+        if (name == "fragment") return GL_FRAGMENT_SHADER;
+        if (name == "geometry") return GL_GEOMETRY_SHADER;
+        if (name == "compute") return GL_COMPUTE_SHADER;
+        return GL_NONE;
+    }
+
+    // single pass over one file: each line is looked at once, plain text becomes pieces of
+    // the mapping and only directive lines split it. "#shader" is only honoured in the file
+    // passed to load(), not in includes.
+    // ------------------------------------------------------------------------
+    bool scan(const std::string &path, const MappedFile *file, int depth)
+    {
+        std::string_view text = file->text();
+        size_t pieceStart = 0;
+        size_t lineStart = 0;
+        while (lineStart < text.size())
+        {
+            const char *newline = static_cast<const char *>(std::memchr(text.data() + lineStart, '\n', text.size() - lineStart));
+            size_t lineEnd = newline != nullptr ? (size_t)(newline - text.data()) + 1 : text.size();
+            std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+
+            std::string_view argument;
+            std::string_view keyword = directive(line, argument);
+            if (keyword == "shader" && depth == 0)
+            {
+                flush(text, pieceStart, lineStart);
+                GLenum type = stageType(argument);
+                if (type == GL_NONE)
+                {
+                    std::cout << "ERROR::SHADER::UNKNOWN_STAGE \"" << argument << "\" in " << path << std::endl;
+                    return false;
+                }
+                // the first "#shader" line replaces the implicit stage along with any preamble
+                if (implicitStage)
+                {
+                    stageList.erase(stageList.begin() + current);
+                    implicitStage = false;
+                }
+                begin(type, file);
+                pieceStart = lineEnd;
+            }
+            else if (keyword == "include")
+            {
+                flush(text, pieceStart, lineStart);
+                pieceStart = lineEnd;
+                if (current >= 0 && !include(path, argument, depth))
+                    return false;
+            }
+            lineStart = lineEnd;
+        }
+        flush(text, pieceStart, text.size());
+        return true;
+    }
+
+    bool include(const std::string &from, std::string_view argument, int depth)
+    {
+        if (argument.size() <= 2 || !((argument.front() == '"' && argument.back() == '"') || (argument.front() == '<' && argument.back() == '>')))
+        {
+            std::cout << "ERROR::SHADER::MALFORMED_INCLUDE " << argument << " in " << from << std::endl;
+            return false;
+        }
+        if (depth >= MAX_INCLUDE_DEPTH)
+        {
+            std::cout << "ERROR::SHADER::INCLUDE_TOO_DEEP in " << from << std::endl;
+            return false;
+        }
+        std::string name(argument.substr(1, argument.size() - 2));
+        std::string path = canonical(name.front() == '/' ? name : from.substr(0, from.rfind('/') + 1) + name);
+        const MappedFile *file = map(path);
+        if (file == nullptr)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << " (included from " << from << ")" << std::endl;
+            return false;
+        }
+        if (!included.insert(file).second)
+            return true; // already part of this stage
+        if (!scan(path, file, depth + 1))
+            return false;
+        // keep the including file's next line from being glued onto the include's last line
+        std::string_view text = file->text();
+        if (!text.empty() && text.back() != '\n')
+            stageList[current].append("\n");
+        return true;
+    }
+
+    void flush(std::string_view text, size_t from, size_t to)
+    {
+        if (to > from && current >= 0)
+            stageList[current].append(text.substr(from, to - from));
+    }
+};
+
+
+#endif /* shaderSource_h */
@@ -0,0 +1,318 @@
+//
+//  main.cpp
+//  Instancing
+//
+//  Created by William Kpabitey Kwabla on 11/10/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include <glm/glm.hpp>
+
+#include "../../OpenGL/OpenGL/src/InstancedMesh.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// 500k triangles plus 250k quads of two triangles each: a million triangles, in two draw calls
+const unsigned int TRIANGLE_INSTANCES = 500000;
+const unsigned int QUAD_INSTANCES = 250000;
+
+// the triangle from moreAttributes, moved around by a per-instance offset and tinted per instance
+const char *triangleVertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec3 aColor;\n"
+"layout (location = 2) in vec2 aOffset;\n"
+"layout (location = 3) in vec4 aTint;\n"
+"uniform float uScale;\n"
+"out vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = vec4(aPos.xy * uScale + aOffset, aPos.z, 1.0);\n"
+"   ourColor = aColor * aTint.rgb;\n"
+"}\0";
+
+// the quad from Rectangle, placed by a per-instance transform matrix
+const char *quadVertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec4 aTint;\n"
+"layout (location = 2) in mat4 aTransform;\n"
+"out vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = aTransform * vec4(aPos, 1.0);\n"
+"   ourColor = aTint.rgb;\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(ourColor, 1.0f);\n"
+"}\n\0";
+
+struct TriangleInstance
+{
+    float offset[2];
+    float tint[4];
+};
+
+struct QuadInstance
+{
+    float tint[4];
+    glm::mat4 transform;
+};
+
+
+int main() {
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Instancing", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+
+    // build and compile our shader programs
+    // ------------------------------------
+    unsigned int triangleProgram = createProgram(triangleVertexShaderSource, fragmentShaderSource);
+    unsigned int quadProgram = createProgram(quadVertexShaderSource, fragmentShaderSource);
+
+
+    // set up vertex data once per mesh, then one instance stream per mesh
+    // ------------------------------------------------------------------
+    std::srand(7);
+    auto random = [](float low, float high) { return low + (high - low) * (float)std::rand() / (float)RAND_MAX; };
+
+    float triangleVertices[] = {
+        // positions         // colors
+        0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom right
+       -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, // bottom left
+        0.0f,  0.5f, 0.0f, 0.0f, 0.0f, 1.0f    // top
+    };
+    InstancedMesh triangle;
+    triangle.setVertices(triangleVertices, sizeof(triangleVertices) / sizeof(float), {{0, 3}, {1, 3}});
+    int triangleStream = triangle.addInstanceStream({{2, 2}, {3, 4}});
+
+    std::vector<TriangleInstance> triangles(TRIANGLE_INSTANCES);
+    for (TriangleInstance& instance : triangles)
+    {
+        instance.offset[0] = random(-1.0f, 0.0f);
+        instance.offset[1] = random(-1.0f, 1.0f);
+        instance.tint[0] = random(0.5f, 1.0f);
+        instance.tint[1] = random(0.5f, 1.0f);
+        instance.tint[2] = random(0.5f, 1.0f);
+        instance.tint[3] = 1.0f;
+    }
+    triangle.setInstances(triangleStream, triangles.data(), triangles.size());
+
+    float quadVertices[] = {
+         0.5f,  0.5f, 0.0f,  // top right
+         0.5f, -0.5f, 0.0f,  // bottom right
+        -0.5f, -0.5f, 0.0f,  // bottom left
+        -0.5f,  0.5f, 0.0f   // top left
+    };
+    unsigned int quadIndices[] = {  // note that we start from 0!
+        0, 1, 3,  // first Triangle
+        1, 2, 3   // second Triangle
+    };
+    InstancedMesh quad;
+    quad.setVertices(quadVertices, sizeof(quadVertices) / sizeof(float), {{0, 3}});
+    quad.setIndices(quadIndices, 6);
+    int quadStream = quad.addInstanceStream({{1, 4}, {2, 16}});
+
+    std::vector<QuadInstance> quads(QUAD_INSTANCES);
+    for (QuadInstance& instance : quads)
+    {
+        // scale, rotate about z, then move into the right half of the screen
+        float angle = random(0.0f, 6.2831853f);
+        float scale = random(0.005f, 0.015f);
+        instance.transform = glm::mat4(1.0f);
+        instance.transform[0][0] = scale * std::cos(angle);
+        instance.transform[0][1] = scale * std::sin(angle);
+        instance.transform[1][0] = -scale * std::sin(angle);
+        instance.transform[1][1] = scale * std::cos(angle);
+        instance.transform[3][0] = random(0.0f, 1.0f);
+        instance.transform[3][1] = random(-1.0f, 1.0f);
+        instance.tint[0] = random(0.2f, 1.0f);
+        instance.tint[1] = random(0.2f, 0.6f);
+        instance.tint[2] = random(0.2f, 1.0f);
+        instance.tint[3] = 1.0f;
+    }
+    quad.setInstances(quadStream, quads.data(), quads.size());
+
+    GLint scaleLocation = glGetUniformLocation(triangleProgram, "uScale");
+    Profiler profiler;
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // one draw call per mesh, however many instances it has
+        profiler.begin("triangles");
+        glUseProgram(triangleProgram);
+        glUniform1f(scaleLocation, 0.01f + 0.005f * (float)std::sin(glfwGetTime()));
+        triangle.draw();
+        profiler.end();
+
+        profiler.begin("quads");
+        glUseProgram(quadProgram);
+        quad.draw();
+        profiler.end();
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    std::cout << "INSTANCING triangles: " << triangle.instanceCount() + quad.instanceCount() * 2 << " in 2 draw calls per frame" << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteProgram(triangleProgram);
+    glDeleteProgram(quadProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
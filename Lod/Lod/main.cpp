@@ -0,0 +1,422 @@
+//
+//  main.cpp
+//  Lod
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../../OpenGL/OpenGL/src/MeshLod.h"
+#include "../../OpenGL/OpenGL/src/MeshPool.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+void makeRock(int subdivisions, std::vector<float>& vertices, std::vector<GLuint>& indices);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// a GRID x GRID field of rocks SPACING apart, each a subdivided icosahedron of 20 * 4^SUBDIVISIONS
+// triangles with a level of detail for every entry of LEVELS
+const int GRID = 24;
+const float SPACING = 10.0f;
+const int SUBDIVISIONS = 5;
+const std::vector<size_t> LEVELS = { 20480, 5120, 1280, 320, 80 };
+const float FOV = 60.0f;
+const float NEAR_PLANE = 0.5f;
+const float FAR_PLANE = 400.0f;
+
+// every rock reads its placement (position, scale) from a texture buffer, at the slot the pool
+// gave its draw
+const char *vertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec3 aNormal;\n"
+"layout (location = 2) in uint aInstance;\n"
+"uniform samplerBuffer uPlacements;\n"
+"uniform mat4 uViewProjection;\n"
+"out vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   vec4 placement = texelFetch(uPlacements, int(aInstance));\n"
+"   gl_Position = uViewProjection * vec4(aPos * placement.w + placement.xyz, 1.0);\n"
+"   float hue = fract(dot(placement.xyz, vec3(0.013, 0.021, 0.017)));\n"
+"   float light = 0.35 + 0.65 * max(dot(aNormal, normalize(vec3(0.4, 0.8, 0.5))), 0.0);\n"
+"   ourColor = (0.5 + 0.5 * cos(6.2831853 * (hue + vec3(0.0, 0.33, 0.67)))) * light;\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(ourColor, 1.0f);\n"
+"}\n\0";
+
+struct Rock
+{
+    float placement[4];   // center, scale
+    int level;
+};
+
+
+int main(int argc, char **argv) {
+
+    // --no-lod draws every rock in full, --no-hysteresis switches levels as soon as the error
+    // crosses the threshold, and --threshold N allows N pixels of error instead of one
+    bool useLod = true;
+    float hysteresis = MeshLod::HYSTERESIS, threshold = MeshLod::THRESHOLD;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--no-lod")
+            useLod = false;
+        else if (argument == "--no-hysteresis")
+            hysteresis = 0.0f;
+        else if (argument == "--threshold" && i + 1 < argc)
+            threshold = (float)std::atof(argv[++i]);
+    }
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Lod", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+
+    // build and compile our shader program
+    // ------------------------------------
+    unsigned int shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+    GLint viewProjectionLocation = glGetUniformLocation(shaderProgram, "uViewProjection");
+    glUseProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "uPlacements"), 0);
+
+
+    // one rock and its levels of detail: the vertices once, every level's indices after the
+    // full mesh's in the pool's index buffer
+    // ------------------------------------------------------------------
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    makeRock(SUBDIVISIONS, vertices, indices);
+    MeshLod::Chain chain = MeshLod::buildChain(indices.data(), indices.size(), vertices.data(), vertices.size() / 6, 6 * sizeof(float), LEVELS);
+    chain.print("rock");
+
+    const unsigned int rockCount = GRID * GRID;
+    MeshPool pool({{0, 3}, {1, 3}}, 2, vertices.size() / 6, chain.indices.size(), rockCount);
+    std::vector<int> levelMeshes;
+    const MeshLod::Level& full = chain.levels[0];
+    levelMeshes.push_back(pool.add(vertices.data(), vertices.size() / 6, chain.indices.data() + full.firstIndex, full.indexCount));
+    for (size_t level = 1; level < chain.levels.size(); ++level)
+        levelMeshes.push_back(pool.addIndices(levelMeshes[0], chain.indices.data() + chain.levels[level].firstIndex, chain.levels[level].indexCount));
+
+    std::srand(5);
+    auto random = [](float low, float high) { return low + (high - low) * (float)std::rand() / (float)RAND_MAX; };
+    std::vector<Rock> rocks(rockCount);
+    const float origin = -GRID * SPACING * 0.5f;
+    for (int z = 0; z < GRID; ++z)
+        for (int x = 0; x < GRID; ++x)
+        {
+            Rock& rock = rocks[(size_t)(z * GRID + x)];
+            rock.placement[0] = origin + (x + random(0.2f, 0.8f)) * SPACING;
+            rock.placement[2] = origin + (z + random(0.2f, 0.8f)) * SPACING;
+            rock.placement[3] = random(1.5f, 3.0f);
+            rock.placement[1] = rock.placement[3] * 0.5f;
+            rock.level = 0;
+        }
+
+    GLuint placementBuffer, placementTexture;
+    glGenBuffers(1, &placementBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, placementBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(rockCount * 4 * sizeof(float)), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glGenTextures(1, &placementTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, placementTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, placementBuffer);
+    std::vector<float> placements(rockCount * 4);
+
+    // the rock's farthest vertex from its center, so distances are to its bounding sphere
+    float radius = 0.0f;
+    for (size_t v = 0; v < vertices.size(); v += 6)
+        radius = std::max(radius, std::sqrt(vertices[v] * vertices[v] + vertices[v + 1] * vertices[v + 1] + vertices[v + 2] * vertices[v + 2]));
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    Profiler profiler;
+    const float pixelsPerUnit = MeshLod::pixelsPerUnit(glm::radians(FOV), (float)SCR_HEIGHT);
+    unsigned long frames = 0, drawnTriangles = 0, changes = 0;
+    std::vector<unsigned long> perLevel(chain.levels.size(), 0);
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+        float time = (float)glfwGetTime();
+
+        // the camera drifts low over the field, looking across it
+        glm::vec3 eye(std::cos(time * 0.1f) * -origin * 0.6f, 4.0f + std::sin(time * 0.3f) * 2.0f, std::sin(time * 0.1f) * -origin * 0.6f);
+        glm::vec3 ahead(-std::sin(time * 0.1f), -0.08f, std::cos(time * 0.1f));
+        glm::mat4 projection = glm::perspective(glm::radians(FOV), (float)SCR_WIDTH / (float)SCR_HEIGHT, NEAR_PLANE, FAR_PLANE);
+        glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + ahead, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        // each rock's level from how large its error would look from here
+        profiler.begin("select");
+        pool.clear();
+        unsigned long triangles = 0;
+        for (Rock& rock : rocks)
+        {
+            int level = 0;
+            if (useLod)
+            {
+                glm::vec3 center(rock.placement[0], rock.placement[1], rock.placement[2]);
+                float distance = std::max(glm::length(center - eye) - radius * rock.placement[3], NEAR_PLANE);
+                level = MeshLod::selectLevel(chain.levels, rock.level, pixelsPerUnit * rock.placement[3] / distance, threshold, hysteresis);
+            }
+            changes += frames > 0 && level != rock.level ? 1 : 0;   // not the first pick
+            rock.level = level;
+            ++perLevel[(size_t)level];
+            triangles += chain.levels[(size_t)level].indexCount / 3;
+
+            GLuint slot = pool.draw(levelMeshes[(size_t)level]);
+            std::copy(rock.placement, rock.placement + 4, &placements[slot * 4]);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, placementBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(rockCount * 4 * sizeof(float)), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)(pool.drawCount() * 4 * sizeof(float)), placements.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        profiler.end();
+        profiler.count("triangles drawn", (double)triangles);
+        profiler.count("triangles saved", (double)(rockCount * (full.indexCount / 3) - triangles));
+        drawnTriangles += triangles;
+        ++frames;
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        profiler.begin("submit");
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+        pool.submit();
+        pool.endFrame();
+        profiler.end();
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    unsigned long perFrame = frames > 0 ? frames : 1;
+    unsigned long fullTriangles = (unsigned long)rockCount * (full.indexCount / 3);
+    std::cout << "MESH_LOD rocks: " << rockCount << " per frame triangles: " << drawnTriangles / perFrame << " of " << fullTriangles
+              << " saved: " << fullTriangles - drawnTriangles / perFrame << " level changes: " << (double)changes / (double)perFrame << " levels:";
+    for (unsigned long count : perLevel)
+        std::cout << " " << count / perFrame;
+    std::cout << " (" << (!useLod ? "no LOD" : "threshold " + std::to_string(threshold) + " px, hysteresis " + std::to_string(hysteresis)) << ")" << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteTextures(1, &placementTexture);
+    glDeleteBuffers(1, &placementBuffer);
+    glDeleteProgram(shaderProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+/*
+ an icosahedron subdivided onto the unit sphere, with a bumpy surface pushed in and out along
+ the normals; interleaved position and smooth normal, every vertex shared
+ */
+void makeRock(int subdivisions, std::vector<float>& vertices, std::vector<GLuint>& indices)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+    std::vector<glm::vec3> positions = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 }, { 0, -1, t }, { 0, 1, t },
+        { 0, -1, -t }, { 0, 1, -t }, { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+    };
+    for (glm::vec3& position : positions)
+        position = glm::normalize(position);
+    indices = { 0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+                3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1 };
+
+    // every triangle into four, with one new vertex per edge
+    for (int i = 0; i < subdivisions; ++i)
+    {
+        std::map<std::pair<GLuint, GLuint>, GLuint> middles;
+        auto middle = [&](GLuint a, GLuint b) {
+            std::pair<GLuint, GLuint> edge(std::min(a, b), std::max(a, b));
+            auto found = middles.find(edge);
+            if (found != middles.end())
+                return found->second;
+            positions.push_back(glm::normalize(positions[a] + positions[b]));
+            return middles[edge] = (GLuint)(positions.size() - 1);
+        };
+        std::vector<GLuint> finer;
+        for (size_t j = 0; j < indices.size(); j += 3)
+        {
+            GLuint a = indices[j], b = indices[j + 1], c = indices[j + 2];
+            GLuint ab = middle(a, b), bc = middle(b, c), ca = middle(c, a);
+            GLuint four[] = { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca };
+            finer.insert(finer.end(), four, four + 12);
+        }
+        indices.swap(finer);
+    }
+
+    for (glm::vec3& position : positions)
+        position *= 1.0f + 0.12f * std::sin(7.0f * position.x) * std::sin(5.0f * position.y) * std::sin(6.0f * position.z)
+                         + 0.04f * std::sin(23.0f * position.x + 17.0f * position.z);
+
+    std::vector<glm::vec3> normals(positions.size(), glm::vec3(0.0f));
+    for (size_t j = 0; j < indices.size(); j += 3)
+    {
+        glm::vec3 face = glm::cross(positions[indices[j + 1]] - positions[indices[j]], positions[indices[j + 2]] - positions[indices[j]]);
+        for (int corner = 0; corner < 3; ++corner)
+            normals[indices[j + (size_t)corner]] += face;
+    }
+    vertices.clear();
+    for (size_t v = 0; v < positions.size(); ++v)
+    {
+        glm::vec3 normal = glm::normalize(normals[v]);
+        float vertex[] = { positions[v].x, positions[v].y, positions[v].z, normal.x, normal.y, normal.z };
+        vertices.insert(vertices.end(), vertex, vertex + 6);
+    }
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
@@ -0,0 +1,90 @@
+//
+//  main.cpp
+//  MeshPack
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Third-party libraries
+#include <GL/glew.h>
+
+#include "../../OpenGL/OpenGL/src/MeshLoader.h"
+#include "../../OpenGL/OpenGL/src/MeshOptimizer.h"
+#include "../../OpenGL/OpenGL/src/PackedMesh.h"
+
+
+
+/*
+ Offline converter from the formats MeshLoader reads to the PackedMesh container:
+
+     MeshPack [--compress] [--keep-order] output.mesh input.obj [input.ply ...]
+
+ every input becomes one submesh, named after its file. Unless --keep-order is given, each is
+ run through MeshOptimizer first (vertex cache, overdraw, then vertex fetch order) and its
+ ACMR/ATVR before and after reported. No GL context is needed.
+ */
+int main(int argc, char **argv) {
+
+    bool compress = false, optimize = true;
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--compress")
+            compress = true;
+        else if (argument == "--keep-order")
+            optimize = false;
+        else if (output.empty())
+            output = argument;
+        else
+            inputs.push_back(argument);
+    }
+    if (output.empty() || inputs.empty())
+    {
+        std::cout << "usage: MeshPack [--compress] [--keep-order] output.mesh input.obj [input.ply ...]" << std::endl;
+        return -1;
+    }
+
+    // load every input
+    // ------------------------------------------------------------------
+    MeshLoader loader;
+    std::vector<MeshData> meshes(inputs.size());
+    std::vector<std::string> names;
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        if (!loader.load(inputs[i], meshes[i]))
+            return -1;
+        std::cout << "MESH_PACK " << inputs[i] << std::endl;
+        loader.printStats();
+
+        std::string name = inputs[i].substr(inputs[i].find_last_of("/\\") + 1);
+        names.push_back(name.substr(0, name.rfind('.')));
+        if (optimize)
+            MeshOptimizer::optimize(meshes[i]).print(names.back());
+    }
+
+    // and pack them
+    // ------------------------------------------------------------------
+    auto start = std::chrono::steady_clock::now();
+    if (!PackedMesh::write(output, names, meshes, compress))
+        return -1;
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t vertices = 0, triangles = 0;
+    for (const MeshData& mesh : meshes)
+    {
+        vertices += mesh.vertices.size();
+        triangles += mesh.indices.size() / 3;
+    }
+    std::cout << "MESH_PACK wrote " << output << ": " << meshes.size() << " submeshes, " << vertices << " vertices, " << triangles
+              << " triangles" << (compress ? " (compressed)" : "") << " in " << milliseconds << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,274 @@
+//
+//  main.cpp
+//  MeshViewer
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <string>
+#include <cmath>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../../OpenGL/OpenGL/src/MeshLoader.h"
+#include "../../OpenGL/OpenGL/src/PackedMesh.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+const char *vertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec3 aNormal;\n"
+"layout (location = 2) in vec2 aTexCoord;\n"
+"uniform mat4 uViewProjection;\n"
+"out vec3 ourNormal;\n"
+"out vec2 ourTexCoord;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = uViewProjection * vec4(aPos, 1.0);\n"
+"   ourNormal = aNormal;\n"
+"   ourTexCoord = aTexCoord;\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec3 ourNormal;\n"
+"in vec2 ourTexCoord;\n"
+"void main()\n"
+"{\n"
+"   float light = 0.25 + 0.75 * abs(dot(normalize(ourNormal), normalize(vec3(0.4, 0.6, 0.7))));\n"
+"   float checker = mod(floor(ourTexCoord.x * 16.0) + floor(ourTexCoord.y * 8.0), 2.0);\n"
+"   FragColor = vec4(vec3(1.0, 0.5, 0.2) * light * (0.8 + 0.2 * checker), 1.0f);\n"
+"}\n\0";
+
+
+int main(int argc, char **argv) {
+
+    // any OBJ, PLY or packed .mesh file; the torus next to this file by default
+    const std::string sourceDirectory = std::string(__FILE__).substr(0, std::string(__FILE__).rfind('/') + 1);
+    const std::string path = argc > 1 ? argv[1] : sourceDirectory + "models/torus.obj";
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "MeshViewer", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+    unsigned int shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+    GLint viewProjectionLocation = glGetUniformLocation(shaderProgram, "uViewProjection");
+
+
+    // load the mesh straight into GL buffers; packed meshes are uploaded from the mapped file
+    // ------------------------------------------------------------------
+    const bool packed = path.size() > 5 && path.compare(path.size() - 5, 5, ".mesh") == 0;
+    MeshLoader loader;
+    MeshBuffers mesh;
+    PackedMesh packedMesh;
+    if (packed ? !packedMesh.load(path) : !loader.load(path, mesh))
+    {
+        glfwTerminate();
+        return -1;
+    }
+    if (packed)
+    {
+        packedMesh.printStats();
+        mesh.vertexCount = packedMesh.header().vertexCount;
+        mesh.indexCount = packedMesh.header().indexCount;
+        for (int k = 0; k < 3; ++k)
+        {
+            mesh.bounds.minimum[k] = packedMesh.header().minimum[k];
+            mesh.bounds.maximum[k] = packedMesh.header().maximum[k];
+        }
+    }
+    else
+        loader.printStats();
+
+    // frame the mesh: orbit its center at a distance that keeps the bounding sphere in view
+    glm::vec3 minimum(mesh.bounds.minimum[0], mesh.bounds.minimum[1], mesh.bounds.minimum[2]);
+    glm::vec3 maximum(mesh.bounds.maximum[0], mesh.bounds.maximum[1], mesh.bounds.maximum[2]);
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius = glm::length(maximum - minimum) * 0.5f;
+    float distance = radius / std::sin(glm::radians(22.5f));
+
+    glEnable(GL_DEPTH_TEST);
+    Profiler profiler;
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        float time = (float)glfwGetTime() * 0.5f;
+        glm::vec3 eye = center + glm::vec3(std::cos(time), 0.6f, std::sin(time)) * distance;
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, distance * 0.05f, distance * 3.0f);
+        glm::mat4 viewProjection = projection * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        profiler.begin("draw");
+        glUseProgram(shaderProgram);
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+        if (packed)
+        {
+            glBindVertexArray(packedMesh.vertexArray());
+            packedMesh.draw();
+        }
+        else
+            mesh.draw();
+        profiler.end();
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    std::cout << "MESH_VIEWER " << path << ": " << mesh.vertexCount << " vertices, " << mesh.indexCount / 3 << " triangles" << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    if (packed)
+        packedMesh.release();
+    else
+        mesh.destroy();
+    glDeleteProgram(shaderProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
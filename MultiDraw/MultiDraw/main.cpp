@@ -0,0 +1,330 @@
+//
+//  main.cpp
+//  MultiDraw
+//
+//  Created by William Kpabitey Kwabla on 11/13/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include "../../OpenGL/OpenGL/src/MeshPool.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+int addPolygon(MeshPool& pool, int sides);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// a GRID x GRID field of meshes over [-WORLD, WORLD]; the camera sees about a quarter of it
+const int GRID = 200;
+const float WORLD = 2.0f;
+
+// every mesh reads its placement (xy offset, scale, hue) from a texture buffer, at the slot
+// the pool gave its draw
+const char *vertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec2 aPos;\n"
+"layout (location = 1) in uint aInstance;\n"
+"uniform samplerBuffer uPlacements;\n"
+"uniform vec4 uView;\n"
+"out vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   vec4 placement = texelFetch(uPlacements, int(aInstance));\n"
+"   vec2 world = aPos * placement.z + placement.xy;\n"
+"   gl_Position = vec4((world - uView.xy) * uView.z, 0.0, 1.0);\n"
+"   ourColor = 0.5 + 0.5 * cos(6.2831853 * (placement.w + vec3(0.0, 0.33, 0.67)));\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(ourColor, 1.0f);\n"
+"}\n\0";
+
+struct Object
+{
+    float placement[4];
+    int mesh;
+};
+
+
+int main(int argc, char **argv) {
+
+    // --no-indirect draws the same list one call per mesh, for comparison
+    bool allowIndirect = true;
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]) == "--no-indirect")
+            allowIndirect = false;
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "MultiDraw", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+
+    // build and compile our shader program
+    // ------------------------------------
+    unsigned int shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+    GLint viewLocation = glGetUniformLocation(shaderProgram, "uView");
+    glUseProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "uPlacements"), 0);
+
+
+    // five polygons, from a triangle to an octagon, all in one pair of buffers
+    // ------------------------------------------------------------------
+    const unsigned int objectCount = GRID * GRID;
+    MeshPool pool({{0, 2}}, 1, 1024, 4096, objectCount, allowIndirect);
+    int polygons[] = {
+        addPolygon(pool, 3),
+        addPolygon(pool, 4),
+        addPolygon(pool, 5),
+        addPolygon(pool, 6),
+        addPolygon(pool, 8)
+    };
+
+    std::srand(5);
+    auto random = [](float low, float high) { return low + (high - low) * (float)std::rand() / (float)RAND_MAX; };
+    std::vector<Object> objects(objectCount);
+    const float cell = 2.0f * WORLD / GRID;
+    for (int y = 0; y < GRID; ++y)
+        for (int x = 0; x < GRID; ++x)
+        {
+            Object& object = objects[(size_t)(y * GRID + x)];
+            object.placement[0] = -WORLD + (x + 0.5f) * cell;
+            object.placement[1] = -WORLD + (y + 0.5f) * cell;
+            object.placement[2] = cell * random(0.3f, 0.5f);
+            object.placement[3] = random(0.0f, 1.0f);
+            object.mesh = polygons[std::rand() % 5];
+        }
+
+    // placements are written per frame, in draw order, to the slots the pool hands out
+    GLuint placementBuffer, placementTexture;
+    glGenBuffers(1, &placementBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, placementBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(objectCount * 4 * sizeof(float)), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glGenTextures(1, &placementTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, placementTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, placementBuffer);
+    std::vector<float> placements(objectCount * 4);
+
+    Profiler profiler;
+    unsigned long drawn = 0;
+    unsigned long frames = 0;
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+
+        // the camera circles the field, so the visible set changes every frame
+        float time = (float)glfwGetTime();
+        float view[4] = { std::cos(time * 0.3f), std::sin(time * 0.3f), 1.0f, 0.0f };
+
+        // list what is on screen
+        profiler.begin("cull");
+        pool.clear();
+        for (const Object& object : objects)
+        {
+            float radius = object.placement[2];
+            if (std::fabs(object.placement[0] - view[0]) > 1.0f / view[2] + radius ||
+                std::fabs(object.placement[1] - view[1]) > 1.0f / view[2] + radius)
+                continue;
+            GLuint slot = pool.draw(object.mesh);
+            for (int i = 0; i < 4; ++i)
+                placements[slot * 4 + (GLuint)i] = object.placement[i];
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, placementBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(objectCount * 4 * sizeof(float)), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)(pool.drawCount() * 4 * sizeof(float)), placements.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        profiler.end();
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        profiler.begin("submit");
+        glUniform4fv(viewLocation, 1, view);
+        pool.submit();
+        pool.endFrame();
+        profiler.end();
+
+        drawn += pool.drawCount();
+        ++frames;
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    std::cout << "MULTI_DRAW meshes: " << objectCount << " drawn: " << (frames > 0 ? drawn / frames : 0) << " per frame in "
+              << (pool.indirect() ? "1 glMultiDrawElementsIndirect" : "one draw call each") << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteTextures(1, &placementTexture);
+    glDeleteBuffers(1, &placementBuffer);
+    glDeleteProgram(shaderProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+/*
+ a regular polygon of radius 1 as a triangle fan around its center
+ */
+int addPolygon(MeshPool& pool, int sides)
+{
+    std::vector<float> vertices = { 0.0f, 0.0f };
+    std::vector<GLuint> indices;
+    for (int i = 0; i < sides; ++i)
+    {
+        float angle = 6.2831853f * (float)i / (float)sides;
+        vertices.push_back(std::cos(angle));
+        vertices.push_back(std::sin(angle));
+        indices.push_back(0);
+        indices.push_back((GLuint)(1 + i));
+        indices.push_back((GLuint)(1 + (i + 1) % sides));
+    }
+    return pool.add(vertices.data(), vertices.size() / 2, indices.data(), indices.size());
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
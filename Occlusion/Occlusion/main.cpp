@@ -0,0 +1,381 @@
+//
+//  main.cpp
+//  Occlusion
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../../OpenGL/OpenGL/src/FrustumCuller.h"
+#include "../../OpenGL/OpenGL/src/InstancedMesh.h"
+#include "../../OpenGL/OpenGL/src/OcclusionCuller.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+void setCube(InstancedMesh& mesh);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// a city of BLOCKS x BLOCKS buildings on a PITCH grid, with STREET-wide streets between them;
+// a cluster of CLUSTER^3 small cubes stands on every crossing and halfway along every street
+const int BLOCKS = 12;
+const float PITCH = 32.0f;
+const float STREET = 8.0f;
+const int CLUSTER = 6;
+const float EYE_HEIGHT = 12.0f;
+const float FAR_PLANE = 300.0f;
+
+// every instance is a box: center and half size
+const char *vertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec3 aNormal;\n"
+"layout (location = 2) in vec3 aCenter;\n"
+"layout (location = 3) in vec3 aHalf;\n"
+"uniform mat4 uViewProjection;\n"
+"out vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = uViewProjection * vec4(aPos * aHalf + aCenter, 1.0);\n"
+"   float hue = fract(dot(aCenter, vec3(0.013, 0.021, 0.017)));\n"
+"   float light = 0.35 + 0.65 * max(dot(aNormal, normalize(vec3(0.4, 0.8, 0.5))), 0.0);\n"
+"   ourColor = (0.5 + 0.5 * cos(6.2831853 * (hue + vec3(0.0, 0.33, 0.67)))) * light;\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(ourColor, 1.0f);\n"
+"}\n\0";
+
+
+int main(int argc, char **argv) {
+
+    // --no-occlusion draws every cluster in the frustum, for comparison
+    bool occlude = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--no-occlusion")
+            occlude = false;
+    }
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Occlusion", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+
+    // build and compile our shader program
+    // ------------------------------------
+    unsigned int shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+    GLint viewProjectionLocation = glGetUniformLocation(shaderProgram, "uViewProjection");
+
+
+    // the buildings are the occluders, drawn every frame in one call; each cluster is an
+    // occludee of its own, one draw that the occlusion culler may skip
+    // ------------------------------------------------------------------
+    std::srand(11);
+    auto random = [](float low, float high) { return low + (high - low) * (float)std::rand() / (float)RAND_MAX; };
+    const float origin = -BLOCKS * PITCH * 0.5f;
+
+    std::vector<float> buildings;
+    for (int z = 0; z < BLOCKS; ++z)
+        for (int x = 0; x < BLOCKS; ++x)
+        {
+            float height = random(20.0f, 60.0f);
+            float building[] = { origin + (x + 0.5f) * PITCH, height, origin + (z + 0.5f) * PITCH,
+                                 (PITCH - STREET) * 0.5f, height, (PITCH - STREET) * 0.5f };
+            buildings.insert(buildings.end(), building, building + 6);
+        }
+    InstancedMesh city;
+    setCube(city);
+    city.setInstances(city.addInstanceStream({{2, 3}, {3, 3}}), buildings.data(), buildings.size() / 6);
+
+    // crossings are on whole multiples of PITCH, street midpoints on halves
+    std::vector<std::unique_ptr<InstancedMesh>> clusters;
+    FrustumCuller frustumCuller;
+    OcclusionCuller occlusion;
+    for (int z = 0; z <= 2 * BLOCKS; ++z)
+        for (int x = 0; x <= 2 * BLOCKS; ++x)
+        {
+            if (x % 2 == 1 && z % 2 == 1)
+                continue;   // a building
+            float center[3] = { origin + x * PITCH * 0.5f, 4.0f, origin + z * PITCH * 0.5f };
+            std::vector<float> cubes;
+            float minimum[3] = { center[0], center[1], center[2] }, maximum[3] = { center[0], center[1], center[2] };
+            for (int k = 0; k < CLUSTER * CLUSTER * CLUSTER; ++k)
+            {
+                float cube[] = { center[0] + (k % CLUSTER - (CLUSTER - 1) * 0.5f) * 1.2f,
+                                 center[1] + (k / CLUSTER % CLUSTER - (CLUSTER - 1) * 0.5f) * 1.2f,
+                                 center[2] + (k / (CLUSTER * CLUSTER) - (CLUSTER - 1) * 0.5f) * 1.2f,
+                                 0.0f, 0.0f, 0.0f };
+                cube[3] = cube[4] = cube[5] = random(0.3f, 0.5f);
+                for (int i = 0; i < 3; ++i)
+                {
+                    minimum[i] = std::min(minimum[i], cube[i] - cube[3 + i]);
+                    maximum[i] = std::max(maximum[i], cube[i] + cube[3 + i]);
+                }
+                cubes.insert(cubes.end(), cube, cube + 6);
+            }
+            clusters.emplace_back(new InstancedMesh());
+            setCube(*clusters.back());
+            clusters.back()->setInstances(clusters.back()->addInstanceStream({{2, 3}, {3, 3}}), cubes.data(), cubes.size() / 6);
+            frustumCuller.add(minimum, maximum);
+            occlusion.add(minimum, maximum);
+        }
+    frustumCuller.rebuild();
+    std::vector<uint32_t> visible;
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    Profiler profiler;
+    unsigned long frames = 0, inFrustum = 0, drawn = 0, skippedOnCpu = 0, skippedOnGpu = 0;
+    double fragmentsSaved = 0.0;
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+        float time = (float)glfwGetTime();
+
+        // the camera walks down the middle street, turning from side to side
+        glm::vec3 eye(0.0f, EYE_HEIGHT, std::sin(time * 0.1f) * -origin * 0.8f);
+        glm::vec3 ahead(std::sin(time * 0.3f) * 0.6f, -0.1f, std::cos(time * 0.1f) >= 0.0f ? 1.0f : -1.0f);
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.5f, FAR_PLANE);
+        glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + ahead, glm::vec3(0.0f, 1.0f, 0.0f));
+        frustumCuller.cull(Frustum::fromMatrix(viewProjection), visible);
+        occlusion.beginFrame(viewProjection, SCR_WIDTH, SCR_HEIGHT);
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        profiler.begin("occluders");
+        glUseProgram(shaderProgram);
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+        city.draw();
+        profiler.end();
+
+        // last frame's queries decide which clusters draw
+        profiler.begin("occludees");
+        for (uint32_t id : visible)
+        {
+            if (occlude && !occlusion.begin(id))
+                continue;
+            clusters[id]->draw();
+            if (occlude)
+                occlusion.end(id);
+            ++drawn;
+        }
+        glBindVertexArray(0);
+        profiler.end();
+
+        // and this frame's queries decide the next
+        if (occlude)
+        {
+            profiler.begin("queries");
+            occlusion.test(visible.data(), visible.size());
+            profiler.end();
+
+            const OcclusionCuller::Stats& stats = occlusion.stats();
+            profiler.count("draws saved", (double)(stats.skippedOnCpu + stats.skippedOnGpu));
+            profiler.count("fragments saved", stats.fragmentsSaved);
+            skippedOnCpu += stats.skippedOnCpu;
+            skippedOnGpu += stats.skippedOnGpu;
+            fragmentsSaved += stats.fragmentsSaved;
+        }
+        inFrustum += visible.size();
+        ++frames;
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    unsigned long perFrame = frames > 0 ? frames : 1;
+    std::cout << "OCCLUSION clusters: " << clusters.size() << " per frame in frustum: " << inFrustum / perFrame << " drawn: " << drawn / perFrame
+              << " skipped by CPU: " << skippedOnCpu / perFrame << " by GPU: " << skippedOnGpu / perFrame
+              << " fragments saved: " << (unsigned long)(fragmentsSaved / (double)perFrame) << " queries: " << occlusion.pooledQueries()
+              << " (" << (!occlude ? "no occlusion" : occlusion.conservative() ? "any samples conservative" : "any samples") << ")" << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteProgram(shaderProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+/*
+ a cube from -1 to 1, four vertices a face so each face has its own normal
+ */
+void setCube(InstancedMesh& mesh)
+{
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    for (int axis = 0; axis < 3; ++axis)
+        for (int side = -1; side <= 1; side += 2)
+        {
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            GLuint first = (GLuint)(vertices.size() / 6);
+            float corners[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+            for (const float* corner : corners)
+            {
+                float position[3], normal[3] = { 0.0f, 0.0f, 0.0f };
+                position[axis] = (float)side;
+                position[u] = corner[0] * (float)side;   // mirrored on the negative side, so both wind outwards
+                position[v] = corner[1];
+                normal[axis] = (float)side;
+                vertices.insert(vertices.end(), position, position + 3);
+                vertices.insert(vertices.end(), normal, normal + 3);
+            }
+            GLuint quad[] = { first, first + 1, first + 2, first + 2, first + 3, first };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    mesh.setVertices(vertices.data(), vertices.size(), {{0, 3}, {1, 3}});
+    mesh.setIndices(indices.data(), indices.size());
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
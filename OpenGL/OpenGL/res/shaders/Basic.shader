@@ -13,7 +13,10 @@ void main()
 
 layout(location = 0) out vec4 color;
 
-uniform vec4 uColor;
+layout(std140) uniform Color
+{
+   vec4 uColor;
+};
 
 void main()
 {
@@ -11,74 +11,54 @@
  */
 #include <iostream>
 #include <string>
-#include <fstream>
-#include <sstream>
 
 
 /*
    Third-party libraries
  */
 #include <GL/glew.h>
+#ifdef HEADLESS
+#include "Headless.h"
+#else
 #include <GLFW/glfw3.h>
+#endif
 
-#define GLEW_STATIC
+#include "../../../HelloTriangle/HelloTriangle/shader/programCache.h"
+#include "../../../HelloTriangle/HelloTriangle/shader/shaderCompiler.h"
+#include "../../../HelloTriangle/HelloTriangle/shader/shaderSource.h"
+#include "../../../HelloTriangle/HelloTriangle/shader/shaderReloader.h"
+#include "Profiler.h"
+#include "UniformBuffer.h"
+#include "GLDebug.h"
+#include "PackedMesh.h"
 
-#define ASSERT(x) if(!(x)) __debugbreak();
-#define glCall(x) glClearError();\
-x;\
-ASSERT(glLogCall)
+#define GLEW_STATIC
 
-static void glClearError(){
-    while (glGetError() != GL_NO_ERROR);
-}
+// Matches the Color block in Basic.shader.
+struct ColorBlock
+{
+    std140::Vec4 uColor;
+};
+STD140_OFFSET(ColorBlock, uColor, 0);
+STD140_SIZE(ColorBlock, 16);
 
+static const GLuint COLOR_BINDING = 0;
 
-static bool glLogCall(){
-    while (GLenum error = glGetError()) {
-        std::cout<< "[OPENGL Error] (" << error << ")" <<std::endl;
-        return false;
-    }
-    
-    return true;
-}
 
+// Drawn with until the real program has finished compiling in the background.
+static const char* fallbackVertexSource = "#version 330 core\n"
+"layout(location = 0) in vec4 position;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = position;\n"
+"}\0";
 
-struct shaderProgramSource {
-    std::string vertexSource;
-    std::string fragmentSource;
-};
-
-static shaderProgramSource parseShader(const std::string& filepath){
-    
-    std::ifstream stream(filepath);
-    
-    enum class shaderType {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
-    
-    std::string line;
-    std::stringstream ss[2];
-    shaderType type = shaderType::NONE;
-    
-    while (getline(stream, line)) {
-        if (line.find("#shader") != std::string::npos) {
-            if (line.find("vertex") != std::string::npos) {
-                type = shaderType::VERTEX;
-                
-            }
-            
-            else if (line.find("fragment") != std::string::npos) {
-                type = shaderType::FRAGMENT;
-            }
-        }
-        else {
-            
-            ss[(int)type] << line << '\n';
-        }
-    }
-    
-    return { ss[0].str(), ss[1].str() };
-}
+static const char* fallbackFragmentSource = "#version 330 core\n"
+"layout(location = 0) out vec4 color;\n"
+"void main()\n"
+"{\n"
+"   color = vec4(0.5, 0.5, 0.5, 1.0);\n"
+"}\0";
 
 static unsigned int compileShader(unsigned int type, const std::string& source)
 {
@@ -87,36 +67,50 @@ static unsigned int compileShader(unsigned int type, const std::string& source)
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
     
+    // the compile status is checked by createShader, and only if linking fails
+    return id;
+}
+
+static void printCompileErrors(unsigned int id)
+{
     int result;
     char infoLog[512];
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE)
     {
         glGetShaderInfoLog(id, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
     }
-    
-    return id;
 }
 
 
-static unsigned int createShader(const std::string& vertexShader, const std::string& fragmentShader)
+static unsigned int createShader(ProgramCache& cache, const std::string& vertexShader, const std::string& fragmentShader)
 {
-    unsigned int program = glCreateProgram();
-    
-    unsigned int vs = compileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragmentShader);
-    
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    
-    glLinkProgram(program);
-    glValidateProgram(program);
-    
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    
-    return program;
+    // only compiles and links when the cache has no usable binary for these sources
+    return cache.load({{GL_VERTEX_SHADER, vertexShader}, {GL_FRAGMENT_SHADER, fragmentShader}}, [&](GLuint program) {
+        unsigned int vs = compileShader(GL_VERTEX_SHADER, vertexShader);
+        unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragmentShader);
+        
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        
+        glLinkProgram(program);
+        glValidateProgram(program);
+        
+        int linked;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE)
+        {
+            char infoLog[512];
+            printCompileErrors(vs);
+            printCompileErrors(fs);
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+    });
 }
 
 
@@ -132,6 +126,9 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#if GL_DEBUG_LAYER
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
     
     GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL", nullptr, nullptr);
     
@@ -151,68 +148,120 @@ int main() {
         return -1;
     }
     
-    GLuint VertexArrayID;
-    glGenVertexArrays(1, &VertexArrayID);
-    glBindVertexArray(VertexArrayID);
-    
-    // Vertex data to use for triangle draw
-    float positions[] = {
-        -0.5f, -0.5f, // 0
-         0.5f, -0.5f, // 1
-         0.5f,  0.5f, // 2
-        -0.5f,  0.5f  // 3
-    };
+    // GL errors are reported by the driver as they happen (debug builds only)
+    GLDebug::enable(GLDebug::Severity::Low);
     
-    GLuint indices[] = {
-        0, 1, 2,
-        2, 3, 0
-    };
+    // res/ sits next to src/, wherever the checkout is (e.g. on a headless build machine)
+    const std::string sourceDirectory = std::string(__FILE__).substr(0, std::string(__FILE__).rfind('/') + 1);
     
-    // Create a buffer or memory on the VRAM and store your vertex in it.
-    //  Create buffer and copy data
-    unsigned int buffer; // Stores the ID of the buffer generated
-    glGenBuffers(1, &buffer); // Generates a buffer and stores the ID in the buffer variable
-    glBindBuffer(GL_ARRAY_BUFFER, buffer); // Select the buffer
-    glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float), positions, GL_STATIC_DRAW); // Copy Data in generated Buffer.
-    
-    
-    // define vertex layout
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, 0);
-    glEnableVertexAttribArray(0);
-    
-    
-    // Create an index buffer or memory on the VRAM and store your vertex in it.
-    unsigned int ibo; // Stores the ID of the buffer generated
-    glGenBuffers(1, &ibo); // Generates a buffer and stores the ID in the buffer variable
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo); // Select the buffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(GLuint), indices, GL_STATIC_DRAW); // Copy Data in generated Buffer.
-    
-    shaderProgramSource source = parseShader("/Users/william/Documents/Personal/OpenGL/OpenGL/OpenGL/res/shaders/Basic.shader");
-    
-    unsigned int shader = createShader(source.vertexSource, source.fragmentSource);
+    // The quad's vertices and indices, packed from res/meshes/quad.obj by MeshPack. The file is
+    // mapped and its buffers go to the VRAM as they are; position feeds location 0 in Basic.shader.
+    PackedMesh quad;
+    if (!quad.load(sourceDirectory + "../res/meshes/quad.mesh"))
+    {
+        glfwTerminate();
+        return -1;
+    }
+    glBindVertexArray(quad.vertexArray());
+    
+    // every stage of Basic.shader, as pieces of the mapped file
+    const std::string basicShaderFile = sourceDirectory + "../res/shaders/Basic.shader";
+    const char* basicShaderPath = basicShaderFile.c_str();
+    ShaderSource source;
+    source.load(basicShaderPath);
+    
+    // start compiling the real program in the background and draw with the fallback until it is ready
+    ProgramCache programCache("shader-cache");
+    ShaderCompiler compiler(&programCache);
+    ShaderCompiler::Handle basic = compiler.add("Basic", source.stages());
+    bool basicPending = true;
+    compiler.submit();
+    
+    unsigned int fallback = createShader(programCache, fallbackVertexSource, fallbackFragmentSource);
+    unsigned int shader = fallback;
     glUseProgram(shader);
     
-    GLint location = glGetUniformLocation(shader, "uColor");
-    glUniform4f(location, 0.8f, 0.3f, 0.8f, 1.0f);
+    // uColor lives in a uniform block shared by every program that declares it
+    UniformBuffers uniforms;
+    uniforms.declare<ColorBlock>("Color", COLOR_BINDING);
+    
+    // edits to Basic.shader (or anything it includes) are rebuilt in the background and swapped in between frames
+    ShaderReloader reloader;
+    reloader.watch("Basic", {{basicShaderPath, GL_NONE}}, [&](GLuint program) {
+        if (shader != fallback)
+            glDeleteProgram(shader);
+        shader = program;
+        uniforms.attach(shader);
+        glUseProgram(shader);
+    });
     
     
     float red = 0.0f;
     float step = 0.05f;
     
+    // frame and section timings; press P for a report, one is printed on exit too
+    Profiler profiler;
+    bool reportKeyDown = false;
+    
     while(!glfwWindowShouldClose(window)){
         
+        profiler.beginFrame();
+        
+        profiler.begin("clear");
         glClearColor(0, 0, 0, 0);
         glClear(GL_COLOR_BUFFER_BIT);
+        profiler.end();
         
-        glUniform4f(location, red, 0.3f, 0.8f, 1.0f);
+        profiler.begin("shaders");
+        reloader.update();
+        
+        // swap in the real program as soon as it has finished compiling, unless a reload got
+        // there first; a failed build leaves the fallback bound
+        if (basicPending)
+        {
+            compiler.poll();
+            ShaderCompiler::Status status = compiler.status(basic);
+            if (status == ShaderCompiler::Status::Ready && shader == fallback)
+            {
+                shader = compiler.program(basic);
+                uniforms.attach(shader);
+                glUseProgram(shader);
+                programCache.printStats();
+            }
+            else if (status == ShaderCompiler::Status::Ready)
+                glDeleteProgram(compiler.program(basic));
+            if (status == ShaderCompiler::Status::Ready || status == ShaderCompiler::Status::Failed)
+            {
+                compiler.remove(basic);
+                basicPending = false;
+            }
+        }
+        profiler.end();
+        
+        profiler.begin("draw");
+        ColorBlock color;
+        color.uColor = std140::Vec4(red, 0.3f, 0.8f, 1.0f);
+        uniforms.upload(COLOR_BINDING, color);
         
         // Draw to screen
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+        glCall(quad.draw());
+        profiler.end();
+        
+        uniforms.endFrame();
         
+        profiler.begin("swap");
         glfwSwapBuffers(window);
+        profiler.end();
+        
+        profiler.endFrame();
         
         glfwPollEvents();
         
+        bool reportKey = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+        if (reportKey && !reportKeyDown)
+            profiler.report();
+        reportKeyDown = reportKey;
+        
         
         // increment red
         if (red < 0.0f || red > 1.0f)
@@ -222,10 +271,13 @@ int main() {
         
     }
     
-    // Cleanup VBO
-    glDeleteBuffers(1, &buffer);
-    glDeleteVertexArrays(1, &VertexArrayID);
-    glDeleteProgram(shader);
+    profiler.report();
+    
+    // Cleanup the quad's buffers
+    quad.release();
+    if (shader != fallback)
+        glDeleteProgram(shader);
+    glDeleteProgram(fallback);
     
     
     // Close OpenGL window and terminate GLFW
@@ -0,0 +1,302 @@
+//
+//  BatchRenderer.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/10/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "StreamBuffer.h"
+
+#include <iostream>
+#include <vector>
+#include <cstddef>
+
+
+/*
+   Draws many 2D quads with few draw calls:
+
+       batch.beginBatch(viewProjection);
+       for (const Sprite& sprite : sprites)
+           batch.submitQuad(sprite.position, sprite.size, sprite.color, sprite.texture);
+       batch.flush();
+
+   Quads are written straight into a StreamBuffer sized for quadsPerFrame quads in each of
+   its frame regions; every batch draws with the same index buffer, filled once with the
+   0 1 2 2 3 0 pattern for maxQuads quads, and finds its vertices through the base vertex.
+   A batch is flushed on its own when it reaches maxQuads or when a quad needs a texture
+   that no longer fits in the texture units, so each draw call covers up to maxQuads quads
+   and MAX_TEXTURES textures.
+ */
+class BatchRenderer
+{
+public:
+    static const int MAX_TEXTURES = 16;    // GL guarantees 16 fragment texture units
+
+    struct Stats
+    {
+        unsigned int drawCalls;
+        unsigned int quads;
+    };
+
+    explicit BatchRenderer(unsigned int maxQuads = 20000, unsigned int quadsPerFrame = 100000)
+        : maxQuads(maxQuads), stream(GL_ARRAY_BUFFER, (GLsizeiptr)(quadsPerFrame > maxQuads ? quadsPerFrame : maxQuads) * 4 * sizeof(Vertex))
+    {
+        program = createProgram();
+        viewProjectionLocation = glGetUniformLocation(program, "uViewProjection");
+        glUseProgram(program);
+        GLint units[MAX_TEXTURES];
+        for (int i = 0; i < MAX_TEXTURES; ++i)
+            units[i] = i;
+        glUniform1iv(glGetUniformLocation(program, "uTextures"), MAX_TEXTURES, units);
+
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, stream.buffer());
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texIndex));
+        glEnableVertexAttribArray(3);
+
+        // the index pattern never changes, so it is built once for every quad the buffer holds
+        std::vector<GLuint> indices((size_t)maxQuads * 6);
+        for (GLuint quad = 0; quad < maxQuads; ++quad)
+        {
+            const GLuint pattern[6] = { 0, 1, 2, 2, 3, 0 };
+            for (int i = 0; i < 6; ++i)
+                indices[(size_t)quad * 6 + i] = quad * 4 + pattern[i];
+        }
+        glGenBuffers(1, &ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+
+        // untextured quads sample a single white texel in unit 0
+        const unsigned char white[4] = { 255, 255, 255, 255 };
+        glGenTextures(1, &whiteTexture);
+        glBindTexture(GL_TEXTURE_2D, whiteTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    ~BatchRenderer()
+    {
+        glDeleteTextures(1, &whiteTexture);
+        glDeleteBuffers(1, &ibo);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteProgram(program);
+    }
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+    // starts a frame's worth of quads; positions are transformed by viewProjection
+    // ------------------------------------------------------------------------
+    void beginBatch(const glm::mat4& viewProjection = glm::mat4(1.0f))
+    {
+        // the previous frame's vertices are fenced; this frame writes the next region
+        if (frameStarted)
+            stream.endFrame();
+        frameStarted = true;
+        this->viewProjection = viewProjection;
+        stats = Stats();
+        quadCount = 0;
+        textureCount = 1;
+        textures[0] = whiteTexture;
+    }
+
+    // adds a quad with its lower left corner at position; texture 0 means untextured
+    // ------------------------------------------------------------------------
+    void submitQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, GLuint texture = 0)
+    {
+        if (quadCount == maxQuads)
+            flush();
+
+        int slot = 0;
+        if (texture != 0)
+        {
+            slot = -1;
+            for (int i = 1; i < textureCount; ++i)
+                if (textures[i] == texture)
+                {
+                    slot = i;
+                    break;
+                }
+            if (slot < 0)
+            {
+                if (textureCount == MAX_TEXTURES)
+                    flush();
+                slot = textureCount++;
+                textures[slot] = texture;
+            }
+        }
+        if (vertices == nullptr)
+        {
+            vertices = static_cast<Vertex*>(stream.reserve((GLsizeiptr)maxQuads * 4 * sizeof(Vertex), sizeof(Vertex)));
+            if (vertices == nullptr)
+                return;
+        }
+
+        const float corners[4][2] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f} };
+        Vertex* vertex = vertices + (size_t)quadCount * 4;
+        for (int i = 0; i < 4; ++i, ++vertex)
+        {
+            vertex->position[0] = position.x + corners[i][0] * size.x;
+            vertex->position[1] = position.y + corners[i][1] * size.y;
+            vertex->color[0] = color.r;
+            vertex->color[1] = color.g;
+            vertex->color[2] = color.b;
+            vertex->color[3] = color.a;
+            vertex->texCoord[0] = corners[i][0];
+            vertex->texCoord[1] = corners[i][1];
+            vertex->texIndex = (float)slot;
+        }
+        ++quadCount;
+        ++stats.quads;
+    }
+
+    // draws everything submitted since the last flush. Leaves the batch's program, vertex
+    // array and textures bound.
+    // ------------------------------------------------------------------------
+    void flush()
+    {
+        GLintptr offset = 0;
+        if (vertices != nullptr)
+            offset = stream.commit((GLsizeiptr)quadCount * 4 * sizeof(Vertex));
+        vertices = nullptr;
+        if (quadCount > 0)
+        {
+            glUseProgram(program);
+            glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+            for (int i = 0; i < textureCount; ++i)
+            {
+                glActiveTexture(GL_TEXTURE0 + i);
+                glBindTexture(GL_TEXTURE_2D, textures[i]);
+            }
+            glActiveTexture(GL_TEXTURE0);
+
+            glBindVertexArray(vao);
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)(quadCount * 6), GL_UNSIGNED_INT, nullptr, (GLint)(offset / (GLintptr)sizeof(Vertex)));
+            ++stats.drawCalls;
+        }
+        quadCount = 0;
+        textureCount = 1;
+    }
+
+    // draw calls and quads since beginBatch()
+    const Stats& getStats() const { return stats; }
+    // how often the CPU had to wait for the GPU to release vertex memory
+    const StreamBuffer::Stats& getStreamStats() const { return stream.stats(); }
+
+private:
+    struct Vertex
+    {
+        float position[2];
+        float color[4];
+        float texCoord[2];
+        float texIndex;
+    };
+
+    unsigned int maxQuads;
+    StreamBuffer stream;
+    Vertex* vertices = nullptr;     // the current batch's reserved stream memory
+    bool frameStarted = false;
+    unsigned int quadCount = 0;
+    GLuint textures[MAX_TEXTURES];
+    int textureCount = 1;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    Stats stats = Stats();
+
+    GLuint program, vao, ibo, whiteTexture;
+    GLint viewProjectionLocation;
+
+    static GLuint createProgram()
+    {
+        const char* vertexSource = "#version 330 core\n"
+        "layout(location = 0) in vec2 aPosition;\n"
+        "layout(location = 1) in vec4 aColor;\n"
+        "layout(location = 2) in vec2 aTexCoord;\n"
+        "layout(location = 3) in float aTexIndex;\n"
+        "uniform mat4 uViewProjection;\n"
+        "out vec4 vColor;\n"
+        "out vec2 vTexCoord;\n"
+        "flat out int vTexIndex;\n"
+        "void main()\n"
+        "{\n"
+        "   vColor = aColor;\n"
+        "   vTexCoord = aTexCoord;\n"
+        "   vTexIndex = int(aTexIndex);\n"
+        "   gl_Position = uViewProjection * vec4(aPosition, 0.0, 1.0);\n"
+        "}\0";
+        // GLSL 3.30 only allows constant indices into sampler arrays, hence the switch
+        const char* fragmentSource = "#version 330 core\n"
+        "in vec4 vColor;\n"
+        "in vec2 vTexCoord;\n"
+        "flat in int vTexIndex;\n"
+        "uniform sampler2D uTextures[16];\n"
+        "out vec4 FragColor;\n"
+        "vec4 sampleTexture(int index)\n"
+        "{\n"
+        "   switch (index)\n"
+        "   {\n"
+        "      case 1: return texture(uTextures[1], vTexCoord);\n"
+        "      case 2: return texture(uTextures[2], vTexCoord);\n"
+        "      case 3: return texture(uTextures[3], vTexCoord);\n"
+        "      case 4: return texture(uTextures[4], vTexCoord);\n"
+        "      case 5: return texture(uTextures[5], vTexCoord);\n"
+        "      case 6: return texture(uTextures[6], vTexCoord);\n"
+        "      case 7: return texture(uTextures[7], vTexCoord);\n"
+        "      case 8: return texture(uTextures[8], vTexCoord);\n"
+        "      case 9: return texture(uTextures[9], vTexCoord);\n"
+        "      case 10: return texture(uTextures[10], vTexCoord);\n"
+        "      case 11: return texture(uTextures[11], vTexCoord);\n"
+        "      case 12: return texture(uTextures[12], vTexCoord);\n"
+        "      case 13: return texture(uTextures[13], vTexCoord);\n"
+        "      case 14: return texture(uTextures[14], vTexCoord);\n"
+        "      case 15: return texture(uTextures[15], vTexCoord);\n"
+        "      default: return texture(uTextures[0], vTexCoord);\n"
+        "   }\n"
+        "}\n"
+        "void main()\n"
+        "{\n"
+        "   FragColor = vColor * sampleTexture(vTexIndex);\n"
+        "}\0";
+
+        int success;
+        char infoLog[512];
+        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertexShader, 1, &vertexSource, NULL);
+        glCompileShader(vertexShader);
+        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+        glCompileShader(fragmentShader);
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::BATCH_RENDERER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return program;
+    }
+};
+
+#endif /* BatchRenderer_h */
@@ -0,0 +1,453 @@
+//
+//  FrustumCuller.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cfloat>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_AVX 1
+#define FRUSTUM_CULLER_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FRUSTUM_CULLER_NEON 1
+#endif
+
+
+/*
+   The six planes of a view-projection matrix (Gribb and Hartmann), normalized and facing
+   inwards: a point p is inside plane i when dot(plane[i].xyz, p) + plane[i].w >= 0.
+ */
+struct Frustum
+{
+    float planes[6][4];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection)
+    {
+        const float* m = glm::value_ptr(viewProjection);   // column-major: row r is m[r], m[4 + r], ...
+        Frustum frustum;
+        for (int i = 0; i < 6; ++i)
+        {
+            int row = i / 2;
+            float sign = i % 2 == 0 ? 1.0f : -1.0f;          // left, right, bottom, top, near, far
+            float* plane = frustum.planes[i];
+            for (int column = 0; column < 4; ++column)
+                plane[column] = m[column * 4 + 3] + sign * m[column * 4 + row];
+            float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            for (int column = 0; column < 4; ++column)
+                plane[column] /= length;
+        }
+        return frustum;
+    }
+};
+
+
+namespace frustum_culler {
+
+// Four boxes against a plane at a time. The boxes are six arrays of four floats (minimum x,
+// y, z, then maximum x, y, z); a box is outside a plane when its corner furthest along the
+// normal is behind it, and wholly inside when the nearest corner is in front.
+#if defined(FRUSTUM_CULLER_SSE2)
+typedef __m128 Float4;
+inline Float4 load4(const float* p) { return _mm_loadu_ps(p); }
+inline Float4 splat4(float value) { return _mm_set1_ps(value); }
+inline Float4 multiplyAdd4(Float4 a, Float4 b, Float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline unsigned negative4(Float4 value) { return (unsigned)_mm_movemask_ps(_mm_cmplt_ps(value, _mm_setzero_ps())); }
+#elif defined(FRUSTUM_CULLER_NEON)
+typedef float32x4_t Float4;
+inline Float4 load4(const float* p) { return vld1q_f32(p); }
+inline Float4 splat4(float value) { return vdupq_n_f32(value); }
+inline Float4 multiplyAdd4(Float4 a, Float4 b, Float4 c) { return vmlaq_f32(c, a, b); }
+inline unsigned negative4(Float4 value)
+{
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+    return vaddvq_u32(vandq_u32(vcltq_f32(value, vdupq_n_f32(0.0f)), vld1q_u32(bits)));
+}
+#else
+struct Float4 { float lane[4]; };
+inline Float4 load4(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+inline Float4 splat4(float value) { return { { value, value, value, value } }; }
+inline Float4 multiplyAdd4(Float4 a, Float4 b, Float4 c)
+{
+    return { { a.lane[0] * b.lane[0] + c.lane[0], a.lane[1] * b.lane[1] + c.lane[1], a.lane[2] * b.lane[2] + c.lane[2], a.lane[3] * b.lane[3] + c.lane[3] } };
+}
+inline unsigned negative4(Float4 value)
+{
+    return (value.lane[0] < 0.0f ? 1u : 0u) | (value.lane[1] < 0.0f ? 2u : 0u) | (value.lane[2] < 0.0f ? 4u : 0u) | (value.lane[3] < 0.0f ? 8u : 0u);
+}
+#endif
+
+// signed distance of each box's corner that is furthest along (or, with nearest, against)
+// the plane's normal
+inline Float4 cornerDistance4(const float* const box[6], size_t at, const float* plane, bool nearest)
+{
+    Float4 distance = splat4(plane[3]);
+    for (int k = 0; k < 3; ++k)
+    {
+        bool maximum = (plane[k] >= 0.0f) != nearest;
+        distance = multiplyAdd4(splat4(plane[k]), load4(box[maximum ? 3 + k : k] + at), distance);
+    }
+    return distance;
+}
+
+// a bit per box (of the lanes lanes starting at at) that is outside one of the planes in planeMask
+inline unsigned outside(const float* const box[6], size_t at, size_t lanes, const Frustum& frustum, unsigned planeMask)
+{
+#if defined(FRUSTUM_CULLER_AVX)
+    if (lanes == 8)
+    {
+        __m256 out = _mm256_setzero_ps();
+        for (int i = 0; i < 6; ++i)
+        {
+            if (!(planeMask & (1u << i)))
+                continue;
+            const float* plane = frustum.planes[i];
+            __m256 distance = _mm256_set1_ps(plane[3]);
+            for (int k = 0; k < 3; ++k)
+                distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[k]), _mm256_loadu_ps(box[plane[k] >= 0.0f ? 3 + k : k] + at)), distance);
+            out = _mm256_or_ps(out, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        return (unsigned)_mm256_movemask_ps(out);
+    }
+#endif
+    unsigned out = 0;
+    for (size_t group = 0; group < lanes; group += 4)
+        for (int i = 0; i < 6; ++i)
+            if (planeMask & (1u << i))
+                out |= negative4(cornerDistance4(box, at + group, frustum.planes[i], false)) << group;
+    return out;
+}
+
+} // namespace frustum_culler
+
+
+/*
+   View-frustum culling for scenes of many objects. Objects are axis-aligned boxes, kept as
+   structure-of-arrays (all minimum x, then all minimum y, ...) so one instruction tests four
+   boxes (SSE2, NEON) or eight (AVX) against a plane:
+
+       FrustumCuller culler;
+       for (const Object& object : objects)
+           object.cullId = culler.add(object.minimum, object.maximum);
+       ...
+       culler.setBounds(mover.cullId, mover.minimum, mover.maximum);   // anything that moved
+       culler.refit();
+       culler.cull(Frustum::fromMatrix(projection * view), visible);
+       for (uint32_t id : visible)
+           ... draw objects[id] ...
+
+   Above the boxes sits a 4-wide bounding volume hierarchy, built once by median splits and
+   refit bottom-up each frame after boxes move (rebuild() if they wander far enough to make
+   the tree loose). Every node holds its four children's boxes, again as arrays, so a node
+   is one 4-wide test per plane: a child that is outside is culled with everything below it,
+   one that is wholly inside a plane stops testing that plane, and one inside all of them is
+   drawn without looking further. Leaves hold up to LEAF_SIZE boxes, tested 4 or 8 at a time.
+
+   stats() counts the last cull(): objects tested one by one, culled and drawn.
+   cullAll() tests every box with the same kernels and no hierarchy, for comparison.
+ */
+class FrustumCuller
+{
+public:
+    static const size_t LEAF_SIZE = 8;
+
+    struct Stats
+    {
+        size_t objects = 0, nodes = 0, tested = 0, culled = 0, drawn = 0;
+    };
+
+    // returns the object's id
+    uint32_t add(const float* minimum, const float* maximum)
+    {
+        uint32_t id = (uint32_t)ids.size();
+        size_t slot = ids.size();
+        ids.push_back(id);
+        slots.push_back((uint32_t)slot);
+        for (std::vector<float>& array : bounds)
+            array.resize(ids.size() + LEAF_SIZE, 0.0f);   // so the last leaf can be read whole
+        setBounds(id, minimum, maximum);
+        built = false;
+        return id;
+    }
+
+    void setBounds(uint32_t id, const float* minimum, const float* maximum)
+    {
+        uint32_t slot = slots[id];
+        for (int k = 0; k < 3; ++k)
+        {
+            bounds[k][slot] = minimum[k];
+            bounds[3 + k][slot] = maximum[k];
+        }
+    }
+
+    size_t size() const { return ids.size(); }
+    const Stats& stats() const { return last; }
+
+    // builds the hierarchy over the boxes as they are now; cull() does this when objects were added
+    void rebuild()
+    {
+        nodes.clear();
+        built = true;
+        if (ids.empty())
+            return;
+
+        // the tree is built over an order of the current slots, which then becomes the slots, so
+        // every leaf and every subtree is a contiguous run
+        std::vector<uint32_t> order(ids.size());
+        centroids.resize(ids.size() * 3);
+        for (size_t slot = 0; slot < ids.size(); ++slot)
+        {
+            order[slot] = (uint32_t)slot;
+            for (int k = 0; k < 3; ++k)
+                centroids[slot * 3 + k] = bounds[k][slot] + bounds[3 + k][slot];
+        }
+        buildNode(order, 0, order.size());
+
+        std::vector<float> reordered(ids.size() + LEAF_SIZE, 0.0f);
+        for (std::vector<float>& array : bounds)
+        {
+            for (size_t slot = 0; slot < order.size(); ++slot)
+                reordered[slot] = array[order[slot]];
+            array.swap(reordered);
+        }
+        std::vector<uint32_t> reorderedIds(ids.size());
+        for (size_t slot = 0; slot < order.size(); ++slot)
+        {
+            reorderedIds[slot] = ids[order[slot]];
+            slots[reorderedIds[slot]] = (uint32_t)slot;
+        }
+        ids.swap(reorderedIds);
+        refit();
+    }
+
+    // recomputes every node's boxes from the objects' current ones, children before parents
+    void refit()
+    {
+        if (!built)
+            return;
+        for (size_t n = nodes.size(); n-- > 0;)
+        {
+            Node& node = nodes[n];
+            for (int c = 0; c < 4; ++c)
+            {
+                // an EMPTY child keeps a box that contains nothing
+                for (int k = 0; k < 3; ++k)
+                {
+                    float low = FLT_MAX, high = -FLT_MAX;
+                    if (node.child[c] == LEAF)
+                    {
+                        const float* minimum = bounds[k].data() + node.first[c];
+                        const float* maximum = bounds[3 + k].data() + node.first[c];
+                        for (uint32_t i = 0; i < node.count[c]; ++i)
+                        {
+                            low = std::min(low, minimum[i]);
+                            high = std::max(high, maximum[i]);
+                        }
+                    }
+                    else if (node.child[c] >= 0)
+                    {
+                        const Node& child = nodes[(size_t)node.child[c]];
+                        for (int i = 0; i < 4; ++i)
+                        {
+                            low = std::min(low, child.bounds[k][i]);
+                            high = std::max(high, child.bounds[3 + k][i]);
+                        }
+                    }
+                    node.bounds[k][c] = low;
+                    node.bounds[3 + k][c] = high;
+                }
+            }
+        }
+    }
+
+    // lists the ids of the objects in or touching the frustum
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible)
+    {
+        if (!built)
+            rebuild();
+        visible.clear();
+        last = Stats();
+        last.objects = ids.size();
+        if (nodes.empty())
+            return;
+
+        const float* objectBounds[6];
+        for (int k = 0; k < 6; ++k)
+            objectBounds[k] = bounds[k].data();
+        const unsigned ALL_PLANES = 0x3F;
+        stack.clear();
+        stack.push_back({ 0, ALL_PLANES });
+        while (!stack.empty())
+        {
+            Entry entry = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[entry.node];
+            ++last.nodes;
+
+            const float* childBounds[6];
+            for (int k = 0; k < 6; ++k)
+                childBounds[k] = node.bounds[k];
+            unsigned out = 0;
+            unsigned planes[4] = { entry.planes, entry.planes, entry.planes, entry.planes };
+            for (int i = 0; i < 6; ++i)
+            {
+                if (!(entry.planes & (1u << i)))
+                    continue;
+                out |= frustum_culler::negative4(frustum_culler::cornerDistance4(childBounds, 0, frustum.planes[i], false));
+                unsigned inside = ~frustum_culler::negative4(frustum_culler::cornerDistance4(childBounds, 0, frustum.planes[i], true));
+                for (int c = 0; c < 4; ++c)
+                    if (inside & (1u << c))
+                        planes[c] &= ~(1u << i);
+            }
+
+            for (int c = 0; c < 4; ++c)
+            {
+                if (node.count[c] == 0 || (out & (1u << c)))
+                    continue;
+                if (planes[c] == 0)
+                {
+                    for (uint32_t slot = node.first[c]; slot < node.first[c] + node.count[c]; ++slot)
+                        visible.push_back(ids[slot]);
+                }
+                else if (node.child[c] == LEAF)
+                {
+                    unsigned leafOut = frustum_culler::outside(objectBounds, node.first[c], LEAF_SIZE, frustum, planes[c]);
+                    for (uint32_t i = 0; i < node.count[c]; ++i)
+                        if (!(leafOut & (1u << i)))
+                            visible.push_back(ids[node.first[c] + i]);
+                    last.tested += node.count[c];
+                }
+                else
+                    stack.push_back({ (uint32_t)node.child[c], planes[c] });
+            }
+        }
+        last.drawn = visible.size();
+        last.culled = last.objects - last.drawn;
+    }
+
+    // the same test on every box, without the hierarchy
+    void cullAll(const Frustum& frustum, std::vector<uint32_t>& visible)
+    {
+        visible.clear();
+        last = Stats();
+        last.objects = last.tested = ids.size();
+        const float* objectBounds[6];
+        for (int k = 0; k < 6; ++k)
+            objectBounds[k] = bounds[k].data();
+        for (size_t first = 0; first < ids.size(); first += LEAF_SIZE)
+        {
+            unsigned out = frustum_culler::outside(objectBounds, first, LEAF_SIZE, frustum, 0x3F);
+            size_t count = std::min(ids.size() - first, (size_t)LEAF_SIZE);   // a copy: min binds references
+            for (size_t i = 0; i < count; ++i)
+                if (!(out & (1u << i)))
+                    visible.push_back(ids[first + i]);
+        }
+        last.drawn = visible.size();
+        last.culled = last.objects - last.drawn;
+    }
+
+    static const char* simdPath()
+    {
+#if defined(FRUSTUM_CULLER_AVX)
+        return "AVX";
+#elif defined(FRUSTUM_CULLER_SSE2)
+        return "SSE2";
+#elif defined(FRUSTUM_CULLER_NEON)
+        return "NEON";
+#else
+        return "scalar";
+#endif
+    }
+
+private:
+    static const int32_t LEAF = -1;
+    static const int32_t EMPTY = -2;
+
+    // four children: boxes as arrays of four, then a node index (or LEAF, or EMPTY) and the
+    // run of object slots below each
+    struct Node
+    {
+        float bounds[6][4];
+        int32_t child[4];
+        uint32_t first[4];
+        uint32_t count[4];
+    };
+    struct Entry
+    {
+        uint32_t node;
+        unsigned planes;   // the ones the node is not yet known to be inside
+    };
+
+    std::vector<float> bounds[6];   // by slot: minimum x, y, z, maximum x, y, z
+    std::vector<uint32_t> ids;      // the object in each slot
+    std::vector<uint32_t> slots;    // the slot of each object
+    std::vector<Node> nodes;        // parents before their children
+    std::vector<Entry> stack;
+    std::vector<float> centroids;
+    bool built = false;
+    Stats last;
+
+    // splits order[begin, end) in two along its centroids' longest axis; the first part is a
+    // whole number of leaves, but a range that fits in one leaf is just halved, so leaves are
+    // not always full (9 boxes become children of 4, 4, 0 and 1)
+    size_t split(std::vector<uint32_t>& order, size_t begin, size_t end)
+    {
+        size_t count = end - begin;
+        if (count <= LEAF_SIZE)
+            return begin + count / 2;
+        float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (size_t i = begin; i < end; ++i)
+            for (int k = 0; k < 3; ++k)
+            {
+                low[k] = std::min(low[k], centroids[order[i] * 3 + k]);
+                high[k] = std::max(high[k], centroids[order[i] * 3 + k]);
+            }
+        int axis = 0;
+        for (int k = 1; k < 3; ++k)
+            if (high[k] - low[k] > high[axis] - low[axis])
+                axis = k;
+        size_t middle = begin + std::min(count, (count / 2 + LEAF_SIZE - 1) / LEAF_SIZE * LEAF_SIZE);
+        const std::vector<float>& centers = centroids;
+        std::nth_element(order.begin() + (std::ptrdiff_t)begin, order.begin() + (std::ptrdiff_t)middle, order.begin() + (std::ptrdiff_t)end,
+                         [&centers, axis](uint32_t a, uint32_t b) { return centers[a * 3 + axis] < centers[b * 3 + axis]; });
+        return middle;
+    }
+
+    uint32_t buildNode(std::vector<uint32_t>& order, size_t begin, size_t end)
+    {
+        uint32_t index = (uint32_t)nodes.size();
+        nodes.emplace_back();
+        size_t middle = split(order, begin, end);
+        size_t parts[5] = { begin, split(order, begin, middle), middle, split(order, middle, end), end };
+        for (int c = 0; c < 4; ++c)
+        {
+            size_t count = parts[c + 1] - parts[c];
+            int32_t child = count == 0 ? EMPTY : count <= LEAF_SIZE ? LEAF : (int32_t)buildNode(order, parts[c], parts[c + 1]);
+            Node& node = nodes[index];
+            node.child[c] = child;
+            node.first[c] = (uint32_t)parts[c];
+            node.count[c] = (uint32_t)count;
+        }
+        return index;
+    }
+};
+
+#endif /* FrustumCuller_h */
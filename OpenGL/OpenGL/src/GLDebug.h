@@ -0,0 +1,220 @@
+//
+//  GLDebug.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/12/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include <GL/glew.h>
+
+#include <iostream>
+#include <csignal>
+
+
+/*
+   GL error reporting for debug builds (DEBUG=1, set by the Debug configuration). Instead of
+   polling glGetError around every call - each poll can make the CPU wait for the GPU - the
+   driver reports errors itself through KHR_debug (core in 4.3), synchronously, so the
+   message is printed while the failing call is still on the stack:
+
+       glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);   // debug builds only
+       ...
+       GLDebug::enable(GLDebug::Severity::Low);              // after glewInit
+       ...
+       glCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr));
+
+   glCall records the call and its file and line, so a message names the call that caused it.
+   Messages below the chosen severity are dropped by the driver. Errors stop in the debugger.
+
+   Where KHR_debug is missing (macOS stops at 4.1), glCall falls back to checking glGetError
+   after the call. In release builds glCall(x) is just x, ASSERT(x) is nothing and enable()
+   does nothing, so none of this costs anything.
+ */
+#if defined(DEBUG) && DEBUG
+#define GL_DEBUG_LAYER 1
+#else
+#define GL_DEBUG_LAYER 0
+#endif
+
+#if defined(_MSC_VER)
+#define GL_DEBUG_BREAK() __debugbreak()
+#elif defined(__clang__)
+#define GL_DEBUG_BREAK() __builtin_debugtrap()
+#else
+#define GL_DEBUG_BREAK() std::raise(SIGTRAP)
+#endif
+
+#if GL_DEBUG_LAYER
+#define ASSERT(x) do { if (!(x)) { std::cout << "ERROR::ASSERT " #x " failed at " << __FILE__ << ":" << __LINE__ << std::endl; GL_DEBUG_BREAK(); } } while (0)
+#define glCall(x) do { GLDebug::enter(#x, __FILE__, __LINE__);\
+x;\
+GLDebug::leave(); } while (0)
+#else
+#define ASSERT(x) do { (void)sizeof(x); } while (0)
+#define glCall(x) x
+#endif
+
+
+namespace GLDebug {
+
+enum class Severity { Notification, Low, Medium, High };
+
+struct Settings
+{
+    Severity minimum = Severity::Low;
+    bool breakOnError = true;
+    bool polling = false;           // no KHR_debug: glCall checks glGetError instead
+};
+
+// the glCall in progress on this thread, if any
+struct Location
+{
+    const char* call = nullptr;
+    const char* file = nullptr;
+    int line = 0;
+};
+
+inline Settings& settings()
+{
+    static Settings value;
+    return value;
+}
+
+inline Location& location()
+{
+    static thread_local Location value;
+    return value;
+}
+
+inline const char* severityName(GLenum severity)
+{
+    switch (severity)
+    {
+        case GL_DEBUG_SEVERITY_HIGH: return "HIGH";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "MEDIUM";
+        case GL_DEBUG_SEVERITY_LOW: return "LOW";
+        default: return "NOTIFICATION";
+    }
+}
+
+inline const char* typeName(GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR: return "ERROR";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "UNDEFINED_BEHAVIOR";
+        case GL_DEBUG_TYPE_PORTABILITY: return "PORTABILITY";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "PERFORMANCE";
+        default: return "OTHER";
+    }
+}
+
+inline Severity severityOf(GLenum severity)
+{
+    switch (severity)
+    {
+        case GL_DEBUG_SEVERITY_HIGH: return Severity::High;
+        case GL_DEBUG_SEVERITY_MEDIUM: return Severity::Medium;
+        case GL_DEBUG_SEVERITY_LOW: return Severity::Low;
+        default: return Severity::Notification;
+    }
+}
+
+inline void printLocation()
+{
+    const Location& at = location();
+    if (at.call != nullptr)
+        std::cout << "    in " << at.call << " at " << at.file << ":" << at.line << std::endl;
+}
+
+inline void GLAPIENTRY messageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user)
+{
+    (void)source;
+    (void)length;
+    (void)user;
+    // some drivers ignore glDebugMessageControl, so filter here as well
+    if (severityOf(severity) < settings().minimum)
+        return;
+    std::cout << "[OPENGL " << typeName(type) << "] " << severityName(severity) << " (" << id << "): " << message << std::endl;
+    printLocation();
+    if (type == GL_DEBUG_TYPE_ERROR && settings().breakOnError)
+        GL_DEBUG_BREAK();
+}
+
+// turns on error reporting for the current context, for messages of at least minimum
+// severity. Returns whether the driver reports through KHR_debug.
+// ------------------------------------------------------------------------
+inline bool enable(Severity minimum = Severity::Low, bool breakOnError = true)
+{
+#if GL_DEBUG_LAYER
+    Settings& current = settings();
+    current.minimum = minimum;
+    current.breakOnError = breakOnError;
+    current.polling = !(GLEW_VERSION_4_3 || GLEW_KHR_debug);
+    if (current.polling)
+    {
+        std::cout << "WARNING::GL_DEBUG KHR_debug is not supported, glCall falls back to glGetError" << std::endl;
+        return false;
+    }
+
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if ((flags & GL_CONTEXT_FLAG_DEBUG_BIT) == 0)
+        std::cout << "WARNING::GL_DEBUG not a debug context, the driver may report less" << std::endl;
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(messageCallback, nullptr);
+
+    // everything off, then each severity from the minimum up back on
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    const GLenum severities[] = { GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH };
+    for (int i = (int)minimum; i < 4; ++i)
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severities[i], 0, nullptr, GL_TRUE);
+    return true;
+#else
+    (void)minimum;
+    (void)breakOnError;
+    return false;
+#endif
+}
+
+inline void enter(const char* call, const char* file, int line)
+{
+    Location& at = location();
+    at.call = call;
+    at.file = file;
+    at.line = line;
+    // errors left over from unchecked calls would be blamed on this one
+    if (settings().polling)
+        while (glGetError() != GL_NO_ERROR);
+}
+
+inline void leave()
+{
+    if (settings().polling)
+    {
+        bool failed = false;
+        while (GLenum error = glGetError())
+        {
+            std::cout << "[OPENGL ERROR] (0x" << std::hex << error << std::dec << ")" << std::endl;
+            failed = true;
+        }
+        if (failed)
+        {
+            printLocation();
+            if (settings().breakOnError)
+                GL_DEBUG_BREAK();
+        }
+    }
+    location() = Location();
+}
+
+} // namespace GLDebug
+
+#endif /* GLDebug_h */
@@ -0,0 +1,332 @@
+//
+//  GpuCuller.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef GPU_CULLER_H
+#define GPU_CULLER_H
+
+#include <GL/glew.h>
+
+#include "FrustumCuller.h"
+#include "MeshPool.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// the CPU reference test must not fuse its multiplies and adds (see below): clang and MSVC
+// take a pragma inside the function, GCC an optimize attribute on it
+#if defined(__GNUC__) && !defined(__clang__)
+#define GPU_CULLER_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define GPU_CULLER_NO_FP_CONTRACT
+#endif
+
+
+/*
+   Frustum culling on the GPU, with the draw list built where it is consumed. Every instance
+   is a placement (center xyz, half size w: the box center - w to center + w) and a mesh of a
+   MeshPool. One compute shader invocation per instance tests its box against the frustum;
+   a survivor takes the next slot of its mesh's draw with an atomicAdd on that command's
+   instanceCount and writes its instance number there:
+
+       commands   one DrawElementsIndirectCommand per mesh; baseInstance is the start of the
+                  mesh's region in visible, instanceCount counts the survivors
+       visible    the surviving instance numbers, region by region
+
+   The commands go straight to glMultiDrawElementsIndirect, so the CPU never reads visibility
+   back. The pool's instance id attribute is a slot of visible; shaders look the instance up
+   through it:
+
+       GpuCuller culler(pool, placements, meshes, count);
+       ...
+       culler.updatePlacements(placements, 0, count);   // anything that moved
+       culler.cull(Frustum::fromMatrix(viewProjection));
+       culler.draw(pool);
+
+       uniform usamplerBuffer uVisible;                 // over visibleBuffer()
+       uniform samplerBuffer uPlacements;               // over placementBuffer()
+       ... texelFetch(uPlacements, int(texelFetch(uVisible, int(aInstance)).r)) ...
+
+   The compute path needs GL 4.3 (and a pool that draws indirect). Without it, cull() runs
+   cullOnCpu() and uploads its result, which is the same commands and, region by region, the
+   same instances; only their order within a region differs, as the atomics hand out slots in
+   whatever order invocations run. Both sides evaluate the plane distances as the same
+   separately rounded multiplies and adds (precise in GLSL), so they agree to the bit; FP
+   contraction is off for the C++ side, which GCC's -ffp-contract=fast would otherwise fuse
+   on FMA targets.
+ */
+class GpuCuller
+{
+public:
+    static const GLuint WORKGROUP_SIZE = 64;
+
+    GpuCuller(const MeshPool& pool, const float* placements, const int* meshes, size_t count, bool allowCompute = true)
+        : instanceCount(count), placementData(placements, placements + count * 4), meshData(meshes, meshes + count)
+    {
+        useCompute = allowCompute && GLEW_VERSION_4_3 && pool.indirect();
+
+        // an instance of a mesh the pool does not have would be counted outside the command
+        // list, on the GPU too; such a culler holds no instances and draws nothing
+        for (size_t i = 0; i < count; ++i)
+            if (meshes[i] < 0 || (size_t)meshes[i] >= pool.meshCount())
+            {
+                std::cout << "ERROR::GPU_CULLER::BAD_MESH instance " << i << " uses mesh " << meshes[i] << " of " << pool.meshCount() << std::endl;
+                count = instanceCount = 0;
+                placementData.clear();
+                meshData.clear();
+                break;
+            }
+
+        // every mesh gets a region of visible as large as its instance count
+        std::vector<GLuint> instancesPerMesh(pool.meshCount(), 0);
+        for (size_t i = 0; i < count; ++i)
+            ++instancesPerMesh[(size_t)meshes[i]];
+        GLuint region = 0;
+        for (size_t mesh = 0; mesh < pool.meshCount(); ++mesh)
+        {
+            const MeshPool::Mesh& target = pool.mesh((int)mesh);
+            templates.push_back({target.indexCount, 0, target.firstIndex, target.baseVertex, region});
+            region += instancesPerMesh[mesh];
+        }
+        commands = templates;
+        visible.resize(count);
+
+        std::vector<GLuint> meshIds(meshes, meshes + count);
+        glGenBuffers(1, &placementBufferId);
+        glGenBuffers(1, &meshBufferId);
+        glGenBuffers(1, &commandBufferId);
+        glGenBuffers(1, &visibleBufferId);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, placementBufferId);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(count * 4 * sizeof(float)), placements, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, meshBufferId);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(count * sizeof(GLuint)), meshIds.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, commandBufferId);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(templates.size() * sizeof(DrawElementsIndirectCommand)), templates.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, visibleBufferId);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(std::max<size_t>(count, 1) * sizeof(GLuint)), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (useCompute)
+            createProgram();
+    }
+    ~GpuCuller()
+    {
+        if (program != 0)
+            glDeleteProgram(program);
+        glDeleteBuffers(1, &visibleBufferId);
+        glDeleteBuffers(1, &commandBufferId);
+        glDeleteBuffers(1, &meshBufferId);
+        glDeleteBuffers(1, &placementBufferId);
+    }
+    GpuCuller(const GpuCuller&) = delete;
+    GpuCuller& operator=(const GpuCuller&) = delete;
+
+    // new placements for instances [first, first + count)
+    void updatePlacements(const float* placements, size_t first, size_t count)
+    {
+        if (first + count > instanceCount)
+            return;
+        std::copy(placements + first * 4, placements + (first + count) * 4, placementData.begin() + (std::ptrdiff_t)(first * 4));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, placementBufferId);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(first * 4 * sizeof(float)), (GLsizeiptr)(count * 4 * sizeof(float)), placements + first * 4);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // fills the command and visible buffers for this frustum
+    // ------------------------------------------------------------------------
+    void cull(const Frustum& frustum)
+    {
+        if (!useCompute)
+        {
+            cullOnCpu(frustum, commands, visible);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, commandBufferId);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)(commands.size() * sizeof(DrawElementsIndirectCommand)), commands.data());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, visibleBufferId);
+            for (const DrawElementsIndirectCommand& command : commands)
+                glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(command.baseInstance * sizeof(GLuint)), (GLsizeiptr)(command.instanceCount * sizeof(GLuint)),
+                                visible.data() + command.baseInstance);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            return;
+        }
+
+        // the counts start from zero again; the shader does the rest
+        glBindBuffer(GL_COPY_WRITE_BUFFER, commandBufferId);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)(templates.size() * sizeof(DrawElementsIndirectCommand)), templates.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glUseProgram(program);
+        glUniform4fv(planesLocation, 6, &frustum.planes[0][0]);
+        glUniform1ui(countLocation, (GLuint)instanceCount);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, placementBufferId);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, meshBufferId);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBufferId);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, visibleBufferId);
+        glDispatchCompute((GLuint)((instanceCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE), 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        for (GLuint binding = 0; binding < 4; ++binding)
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+        glUseProgram(0);
+    }
+
+    // the commands of the last cull(), one glMultiDrawElementsIndirect (or one draw per mesh
+    // where the pool cannot draw indirect)
+    void draw(MeshPool& pool, GLenum mode = GL_TRIANGLES)
+    {
+        if (pool.indirect())
+            pool.submitIndirect(commandBufferId, (GLsizei)templates.size(), mode);
+        else
+            pool.submit(commands.data(), commands.size(), mode);
+    }
+
+    // what the compute shader does, on the CPU
+    // ------------------------------------------------------------------------
+    void cullOnCpu(const Frustum& frustum, std::vector<DrawElementsIndirectCommand>& commandList, std::vector<GLuint>& visibleList) const
+    {
+        commandList = templates;
+        visibleList.resize(instanceCount);
+        for (size_t i = 0; i < instanceCount; ++i)
+        {
+            if (outside(&placementData[i * 4], frustum))
+                continue;
+            DrawElementsIndirectCommand& command = commandList[(size_t)meshData[i]];
+            visibleList[command.baseInstance + command.instanceCount++] = (GLuint)i;
+        }
+    }
+
+    // the GPU's result of the last cull(), with each region sorted; stalls, so for testing only
+    void readBack(std::vector<DrawElementsIndirectCommand>& commandList, std::vector<GLuint>& visibleList) const
+    {
+        commandList.resize(templates.size());
+        visibleList.resize(instanceCount);
+        glBindBuffer(GL_COPY_READ_BUFFER, commandBufferId);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)(commandList.size() * sizeof(DrawElementsIndirectCommand)), commandList.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, visibleBufferId);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)(visibleList.size() * sizeof(GLuint)), visibleList.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        sortRegions(commandList, visibleList);
+    }
+
+    static void sortRegions(const std::vector<DrawElementsIndirectCommand>& commandList, std::vector<GLuint>& visibleList)
+    {
+        for (const DrawElementsIndirectCommand& command : commandList)
+            std::sort(visibleList.begin() + command.baseInstance, visibleList.begin() + command.baseInstance + command.instanceCount);
+    }
+
+    // the last cull()'s commands on the CPU path; the compute path's stay on the GPU
+    const std::vector<DrawElementsIndirectCommand>& cpuCommands() const { return commands; }
+
+    bool compute() const { return useCompute; }
+    size_t size() const { return instanceCount; }
+    GLuint placementBuffer() const { return placementBufferId; }
+    GLuint visibleBuffer() const { return visibleBufferId; }
+
+private:
+    size_t instanceCount;
+    std::vector<float> placementData;
+    std::vector<int> meshData;
+    std::vector<DrawElementsIndirectCommand> templates;   // instanceCount 0
+    std::vector<DrawElementsIndirectCommand> commands;    // the CPU path's
+    std::vector<GLuint> visible;
+    bool useCompute = false;
+
+    GLuint placementBufferId = 0, meshBufferId = 0, commandBufferId = 0, visibleBufferId = 0;
+    GLuint program = 0;
+    GLint planesLocation = -1, countLocation = -1;
+
+    // the box's corner furthest along each plane's normal, as the shader computes it
+    GPU_CULLER_NO_FP_CONTRACT static bool outside(const float* placement, const Frustum& frustum)
+    {
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+        for (int i = 0; i < 6; ++i)
+        {
+            const float* plane = frustum.planes[i];
+            float distance = plane[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                float corner = plane[k] >= 0.0f ? placement[k] + placement[3] : placement[k] - placement[3];
+                float product = plane[k] * corner;
+                distance = distance + product;
+            }
+            if (distance < 0.0f)
+                return true;
+        }
+        return false;
+    }
+
+    void createProgram()
+    {
+        const char* computeSource = "#version 430 core\n"
+        "layout (local_size_x = 64) in;\n"
+        "struct Command { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };\n"
+        "layout (std430, binding = 0) readonly buffer Placements { vec4 placements[]; };\n"
+        "layout (std430, binding = 1) readonly buffer Meshes { uint meshes[]; };\n"
+        "layout (std430, binding = 2) buffer Commands { Command commands[]; };\n"
+        "layout (std430, binding = 3) writeonly buffer Visible { uint visible[]; };\n"
+        "uniform vec4 uPlanes[6];\n"
+        "uniform uint uCount;\n"
+        "void main()\n"
+        "{\n"
+        "   uint id = gl_GlobalInvocationID.x;\n"
+        "   if (id >= uCount)\n"
+        "       return;\n"
+        "   vec4 placement = placements[id];\n"
+        "   for (int i = 0; i < 6; ++i)\n"
+        "   {\n"
+        "       vec4 plane = uPlanes[i];\n"
+        "       precise float distance = plane.w;\n"
+        "       for (int k = 0; k < 3; ++k)\n"
+        "       {\n"
+        "           precise float corner = plane[k] >= 0.0 ? placement[k] + placement.w : placement[k] - placement.w;\n"
+        "           precise float product = plane[k] * corner;\n"
+        "           distance = distance + product;\n"
+        "       }\n"
+        "       if (distance < 0.0)\n"
+        "           return;\n"
+        "   }\n"
+        "   uint mesh = meshes[id];\n"
+        "   uint slot = atomicAdd(commands[mesh].instanceCount, 1u);\n"
+        "   visible[commands[mesh].baseInstance + slot] = id;\n"
+        "}\n\0";
+
+        int success;
+        char infoLog[512];
+        GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(shader, 1, &computeSource, NULL);
+        glCompileShader(shader);
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cout << "ERROR::GPU_CULLER::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        program = glCreateProgram();
+        glAttachShader(program, shader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (success)
+        {
+            planesLocation = glGetUniformLocation(program, "uPlanes");
+            countLocation = glGetUniformLocation(program, "uCount");
+        }
+        else
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::GPU_CULLER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            glDeleteProgram(program);
+            program = 0;
+            useCompute = false;   // the CPU path still works
+        }
+        glDeleteShader(shader);
+    }
+};
+
+#endif /* GpuCuller_h */
@@ -0,0 +1,375 @@
+//
+//  Headless.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/2/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+/*
+   Headless stand-in for the part of GLFW the demos use, for machines without a display or
+   GPU (e.g. Mesa llvmpipe on a build farm). Build a demo with -DHEADLESS and this header
+   replaces <GLFW/glfw3.h>:
+
+       g++ -std=gnu++17 -DHEADLESS main.cpp -lGLEW -lEGL -lGL            (EGL surfaceless)
+       g++ -std=gnu++17 -DHEADLESS -DHEADLESS_OSMESA main.cpp -lGLEW -lOSMesa
+
+   The "window" is an offscreen framebuffer object that stays bound, so the demo's GL code
+   runs unchanged. The render loop ends after HEADLESS_FRAMES frames (default 300), and
+   glfwTerminate() prints frame time statistics. Set HEADLESS_CAPTURE=<file.ppm> to save the
+   last frame for image comparisons.
+ */
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <GL/glew.h>
+#ifdef HEADLESS_OSMESA
+#include <GL/osmesa.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+
+#define GLFW_RELEASE                0
+#define GLFW_PRESS                  1
+#define GLFW_KEY_P                  80
+#define GLFW_KEY_ESCAPE             256
+#define GLFW_VISIBLE                0x00020004
+#define GLFW_CONTEXT_VERSION_MAJOR  0x00022002
+#define GLFW_CONTEXT_VERSION_MINOR  0x00022003
+#define GLFW_OPENGL_FORWARD_COMPAT  0x00022006
+#define GLFW_OPENGL_DEBUG_CONTEXT   0x00022007
+#define GLFW_OPENGL_PROFILE         0x00022008
+#define GLFW_OPENGL_CORE_PROFILE    0x00032001
+
+struct GLFWmonitor;
+typedef void (*GLFWframebuffersizefun)(struct GLFWwindow*, int, int);
+
+struct GLFWwindow
+{
+    int width;
+    int height;
+    bool shouldClose;
+    GLFWframebuffersizefun framebufferSizeCallback;
+    GLuint framebuffer;
+    GLuint renderbuffers[2];
+#ifdef HEADLESS_OSMESA
+    OSMesaContext context;
+    std::vector<unsigned char> buffer;
+#else
+    EGLDisplay display;
+    EGLContext context;
+#endif
+};
+
+namespace headless {
+
+// in-flight frames are capped like a real swap chain would, so frame times include GPU work
+static const int MAX_FRAMES_IN_FLIGHT = 2;
+
+struct State
+{
+    int contextMajor = 3;
+    int contextMinor = 3;
+    bool coreProfile = false;
+    bool forwardCompatible = false;
+    bool debugContext = false;
+
+    long frameLimit = 300;
+    long frames = 0;
+    bool looping = false;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point lastSwap;
+    std::vector<double> frameTimes;
+    GLsync fences[MAX_FRAMES_IN_FLIGHT] = {};
+    GLFWwindow* window = nullptr;
+};
+
+inline State& state()
+{
+    static State instance;
+    return instance;
+}
+
+inline double percentile(std::vector<double> sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+inline void printStats()
+{
+    State& s = state();
+    std::vector<double> times = s.frameTimes;
+    std::sort(times.begin(), times.end());
+    double total = 0.0;
+    for (double time : times)
+        total += time / 1000.0;
+    double average = times.empty() ? 0.0 : total * 1000.0 / (double)times.size();
+    std::cout << "HEADLESS frames: " << s.frames
+              << " total: " << total << " s"
+              << " avg: " << average << " ms (" << (total > 0.0 ? (double)s.frames / total : 0.0) << " fps)"
+              << " p50: " << percentile(times, 0.50) << " ms"
+              << " p95: " << percentile(times, 0.95) << " ms"
+              << " p99: " << percentile(times, 0.99) << " ms"
+              << " max: " << (times.empty() ? 0.0 : times.back()) << " ms" << std::endl;
+}
+
+// writes the offscreen color buffer as a binary PPM, top row first
+inline void capture(GLFWwindow* window, const char* path)
+{
+    std::vector<unsigned char> pixels((size_t)window->width * window->height * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, window->framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, window->width, window->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << window->width << " " << window->height << "\n255\n";
+    for (int y = window->height - 1; y >= 0; --y)
+        for (int x = 0; x < window->width; ++x)
+            file.write(reinterpret_cast<const char*>(&pixels[((size_t)y * window->width + x) * 4]), 3);
+}
+
+} // namespace headless
+
+
+inline int glfwInit(void)
+{
+    headless::State& s = headless::state();
+    if (const char* frames = std::getenv("HEADLESS_FRAMES"))
+        s.frameLimit = std::max(1L, std::atol(frames));
+    s.start = std::chrono::steady_clock::now();
+    return 1;
+}
+
+inline void glfwWindowHint(int hint, int value)
+{
+    headless::State& s = headless::state();
+    switch (hint)
+    {
+        case GLFW_CONTEXT_VERSION_MAJOR: s.contextMajor = value; break;
+        case GLFW_CONTEXT_VERSION_MINOR: s.contextMinor = value; break;
+        case GLFW_OPENGL_PROFILE: s.coreProfile = value == GLFW_OPENGL_CORE_PROFILE; break;
+        case GLFW_OPENGL_FORWARD_COMPAT: s.forwardCompatible = value != 0; break;
+        case GLFW_OPENGL_DEBUG_CONTEXT: s.debugContext = value != 0; break;
+        default: break;
+    }
+}
+
+inline GLFWwindow* glfwCreateWindow(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share)
+{
+    (void)monitor;
+    (void)share;
+    headless::State& s = headless::state();
+    GLFWwindow* window = new GLFWwindow();
+    window->width = width;
+    window->height = height;
+
+#ifdef HEADLESS_OSMESA
+    const int attributes[] = {
+        OSMESA_FORMAT, OSMESA_RGBA,
+        OSMESA_DEPTH_BITS, 24,
+        OSMESA_STENCIL_BITS, 8,
+        OSMESA_PROFILE, s.coreProfile ? OSMESA_CORE_PROFILE : OSMESA_COMPAT_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, s.contextMajor,
+        OSMESA_CONTEXT_MINOR_VERSION, s.contextMinor,
+        0
+    };
+    window->context = OSMesaCreateContextAttribs(attributes, nullptr);
+    if (window->context == nullptr)
+    {
+        std::cout << "HEADLESS::OSMESA failed to create a " << s.contextMajor << "." << s.contextMinor << " context for " << title << std::endl;
+        delete window;
+        return nullptr;
+    }
+    window->buffer.resize((size_t)width * height * 4);
+#else
+    // a surfaceless display needs neither X11 nor a GPU; fall back to the default display
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    window->display = getPlatformDisplay != nullptr ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) : EGL_NO_DISPLAY;
+    if (window->display == EGL_NO_DISPLAY)
+        window->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (window->display == EGL_NO_DISPLAY || !eglInitialize(window->display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "HEADLESS::EGL failed to initialize a display for " << title << std::endl;
+        delete window;
+        return nullptr;
+    }
+    const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+    eglChooseConfig(window->display, configAttributes, &config, 1, &configs);
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, s.contextMajor,
+        EGL_CONTEXT_MINOR_VERSION, s.contextMinor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, s.coreProfile ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, s.forwardCompatible ? EGL_TRUE : EGL_FALSE,
+        EGL_CONTEXT_OPENGL_DEBUG, s.debugContext ? EGL_TRUE : EGL_FALSE,
+        EGL_NONE
+    };
+    // surfaceless contexts do not need a config (EGL_KHR_no_config_context)
+    window->context = eglCreateContext(window->display, configs > 0 ? config : (EGLConfig)0, EGL_NO_CONTEXT, contextAttributes);
+    if (window->context == EGL_NO_CONTEXT)
+    {
+        std::cout << "HEADLESS::EGL failed to create a " << s.contextMajor << "." << s.contextMinor << " context for " << title << std::endl;
+        eglTerminate(window->display);
+        delete window;
+        return nullptr;
+    }
+#endif
+    s.window = window;
+    return window;
+}
+
+inline void glfwMakeContextCurrent(GLFWwindow* window)
+{
+#ifdef HEADLESS_OSMESA
+    OSMesaMakeCurrent(window->context, window->buffer.data(), GL_UNSIGNED_BYTE, window->width, window->height);
+#else
+    eglMakeCurrent(window->display, EGL_NO_SURFACE, EGL_NO_SURFACE, window->context);
+#endif
+    // the offscreen "window" needs framebuffer objects before the demo initialises GLEW itself
+    glewExperimental = GL_TRUE;
+    glewInit();
+
+    glGenFramebuffers(1, &window->framebuffer);
+    glGenRenderbuffers(2, window->renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, window->width, window->height);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, window->width, window->height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, window->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, window->renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, window->renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    // without a surface there is no default viewport
+    glViewport(0, 0, window->width, window->height);
+}
+
+inline GLFWframebuffersizefun glfwSetFramebufferSizeCallback(GLFWwindow* window, GLFWframebuffersizefun callback)
+{
+    GLFWframebuffersizefun previous = window->framebufferSizeCallback;
+    window->framebufferSizeCallback = callback;
+    return previous;
+}
+
+inline void glfwGetFramebufferSize(GLFWwindow* window, int* width, int* height)
+{
+    if (width != nullptr)
+        *width = window->width;
+    if (height != nullptr)
+        *height = window->height;
+}
+
+inline int glfwWindowShouldClose(GLFWwindow* window)
+{
+    // the first check marks the start of the render loop, so setup is not counted as a frame
+    headless::State& s = headless::state();
+    if (!s.looping)
+    {
+        s.looping = true;
+        s.lastSwap = std::chrono::steady_clock::now();
+    }
+    return window->shouldClose || headless::state().frames >= headless::state().frameLimit;
+}
+
+inline void glfwSetWindowShouldClose(GLFWwindow* window, int value)
+{
+    window->shouldClose = value != 0;
+}
+
+inline void glfwSwapInterval(int interval)
+{
+    (void)interval;
+}
+
+inline void glfwPollEvents(void)
+{
+}
+
+inline int glfwGetKey(GLFWwindow* window, int key)
+{
+    (void)window;
+    (void)key;
+    return GLFW_RELEASE;
+}
+
+inline double glfwGetTime(void)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - headless::state().start).count();
+}
+
+// ends a frame: waits for the frame MAX_FRAMES_IN_FLIGHT back to finish, then records the time
+inline void glfwSwapBuffers(GLFWwindow* window)
+{
+    (void)window;
+    headless::State& s = headless::state();
+    GLsync& fence = s.fences[s.frames % headless::MAX_FRAMES_IN_FLIGHT];
+    if (fence != nullptr)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    s.frameTimes.push_back(std::chrono::duration<double, std::milli>(now - s.lastSwap).count());
+    s.lastSwap = now;
+    ++s.frames;
+}
+
+inline void glfwTerminate(void)
+{
+    headless::State& s = headless::state();
+    GLFWwindow* window = s.window;
+    if (window == nullptr)
+        return;
+    glFinish();
+    headless::printStats();
+    if (const char* path = std::getenv("HEADLESS_CAPTURE"))
+        headless::capture(window, path);
+
+    for (GLsync& fence : s.fences)
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    glDeleteFramebuffers(1, &window->framebuffer);
+    glDeleteRenderbuffers(2, window->renderbuffers);
+#ifdef HEADLESS_OSMESA
+    OSMesaDestroyContext(window->context);
+#else
+    eglMakeCurrent(window->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(window->display, window->context);
+    eglTerminate(window->display);
+#endif
+    delete window;
+    s.window = nullptr;
+}
+
+
+// GLEW built for GLX reports a missing X display under EGL/OSMesa even though every GL entry
+// point has been loaded; the demos treat anything but GLEW_OK as fatal, so hide that case.
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+inline GLenum headlessGlewInit(void)
+{
+    GLenum result = glewInit();
+    return result == GLEW_ERROR_NO_GLX_DISPLAY ? (GLenum)GLEW_OK : result;
+}
+#define glewInit headlessGlewInit
+#endif
+
+
+#endif /* Headless_h */
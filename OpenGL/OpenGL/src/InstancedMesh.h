@@ -0,0 +1,183 @@
+//
+//  InstancedMesh.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/10/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef INSTANCED_MESH_H
+#define INSTANCED_MESH_H
+
+#include <GL/glew.h>
+
+#include <vector>
+#include <initializer_list>
+#include <cstddef>
+
+
+/*
+   A mesh drawn many times in one call. The per-vertex data is described once, and any number
+   of per-instance streams (offsets, colors, transform matrices, ...) are added next to it;
+   each stream is its own buffer of interleaved float attributes, advanced once per instance
+   with glVertexAttribDivisor:
+
+       InstancedMesh triangle;
+       triangle.setVertices(vertices, 18, {{0, 3}, {1, 3}});        // position, color
+       int stream = triangle.addInstanceStream({{2, 2}, {3, 4}});   // offset, color
+       triangle.setInstances(stream, instances.data(), count);
+       triangle.draw();
+
+   An attribute wider than four floats (a mat4 is {location, 16}) takes one location per
+   column, so a matrix at location 4 also uses 5, 6 and 7. draw() uses glDrawElementsInstanced
+   when indices were given and glDrawArraysInstanced otherwise.
+ */
+class InstancedMesh
+{
+public:
+    struct Attribute
+    {
+        GLuint location;
+        GLint components;   // floats; 16 for a mat4
+    };
+
+    InstancedMesh()
+    {
+        glGenVertexArrays(1, &vao);
+    }
+    ~InstancedMesh()
+    {
+        for (const Stream& stream : streams)
+            glDeleteBuffers(1, &stream.buffer);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+        glDeleteVertexArrays(1, &vao);
+    }
+    InstancedMesh(const InstancedMesh&) = delete;
+    InstancedMesh& operator=(const InstancedMesh&) = delete;
+
+    // interleaved per-vertex floats, laid out as the attributes say
+    // ------------------------------------------------------------------------
+    void setVertices(const float* data, size_t floats, std::initializer_list<Attribute> layout)
+    {
+        if (vbo == 0)
+            glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, floats * sizeof(float), data, GL_STATIC_DRAW);
+        GLsizei stride = describe(layout, 0);
+        vertexCount = stride > 0 ? (GLsizei)(floats * sizeof(float) / (size_t)stride) : 0;
+        glBindVertexArray(0);
+    }
+
+    void setIndices(const GLuint* data, size_t count)
+    {
+        if (ebo == 0)
+            glGenBuffers(1, &ebo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), data, GL_STATIC_DRAW);
+        glBindVertexArray(0);
+        indexCount = (GLsizei)count;
+    }
+
+    // adds a buffer of interleaved per-instance attributes and returns its stream number.
+    // divisor 1 advances the attributes every instance, 2 every other instance, and so on.
+    // ------------------------------------------------------------------------
+    int addInstanceStream(std::initializer_list<Attribute> layout, GLuint divisor = 1)
+    {
+        Stream stream;
+        glGenBuffers(1, &stream.buffer);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+        stream.stride = describe(layout, divisor);
+        glBindVertexArray(0);
+        streams.push_back(stream);
+        return (int)streams.size() - 1;
+    }
+
+    // fills a stream with one element per instance; the smallest stream decides how many
+    // instances draw() renders. Use GL_DYNAMIC_DRAW for data rewritten every frame.
+    // ------------------------------------------------------------------------
+    void setInstances(int stream, const void* data, size_t instances, GLenum usage = GL_STATIC_DRAW)
+    {
+        Stream& target = streams[(size_t)stream];
+        glBindBuffer(GL_ARRAY_BUFFER, target.buffer);
+        if (instances == target.instances && usage == target.usage)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(instances * (size_t)target.stride), data);
+        }
+        else
+        {
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(instances * (size_t)target.stride), data, usage);
+            target.instances = instances;
+            target.usage = usage;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    size_t instanceCount() const
+    {
+        if (streams.empty())
+            return 0;
+        size_t count = streams[0].instances;
+        for (const Stream& stream : streams)
+            count = stream.instances < count ? stream.instances : count;
+        return count;
+    }
+
+    GLuint vertexArray() const { return vao; }
+
+    void draw(GLenum mode = GL_TRIANGLES) const
+    {
+        GLsizei instances = (GLsizei)instanceCount();
+        if (instances == 0)
+            return;
+        glBindVertexArray(vao);
+        if (indexCount > 0)
+            glDrawElementsInstanced(mode, indexCount, GL_UNSIGNED_INT, nullptr, instances);
+        else
+            glDrawArraysInstanced(mode, 0, vertexCount, instances);
+    }
+
+private:
+    struct Stream
+    {
+        GLuint buffer = 0;
+        GLsizei stride = 0;
+        size_t instances = 0;
+        GLenum usage = GL_NONE;
+    };
+
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    GLsizei vertexCount = 0;
+    GLsizei indexCount = 0;
+    std::vector<Stream> streams;
+
+    // points the attributes at the bound GL_ARRAY_BUFFER and returns the stride
+    static GLsizei describe(std::initializer_list<Attribute> layout, GLuint divisor)
+    {
+        GLsizei stride = 0;
+        for (const Attribute& attribute : layout)
+            stride += attribute.components * (GLsizei)sizeof(float);
+        size_t offset = 0;
+        for (const Attribute& attribute : layout)
+        {
+            // vertex attributes hold at most four floats, so wider ones are split into columns
+            for (GLint column = 0; column * 4 < attribute.components; ++column)
+            {
+                GLuint location = attribute.location + (GLuint)column;
+                GLint components = attribute.components - column * 4 < 4 ? attribute.components - column * 4 : 4;
+                glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, stride, (void*)(offset + (size_t)column * 4 * sizeof(float)));
+                glEnableVertexAttribArray(location);
+                glVertexAttribDivisor(location, divisor);
+            }
+            offset += (size_t)attribute.components * sizeof(float);
+        }
+        return stride;
+    }
+};
+
+#endif /* InstancedMesh_h */
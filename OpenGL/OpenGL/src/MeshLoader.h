@@ -0,0 +1,1331 @@
+//
+//  MeshLoader.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <GL/glew.h>
+
+#include "VertexLayout.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <cfloat>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+
+// what the loader produces: 32 bytes, positions at location 0, normals at 1, texcoords at 2
+struct MeshVertex
+{
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+};
+using MeshVertexLayout = VertexLayout<MeshVertex,
+    VERTEX_ATTRIBUTE(MeshVertex, position, 0),
+    VERTEX_ATTRIBUTE(MeshVertex, normal, 1),
+    VERTEX_ATTRIBUTE(MeshVertex, texCoord, 2)>;
+
+// axis-aligned box around a mesh's positions; empty until something is included
+struct MeshBounds
+{
+    float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    void include(const float* point)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            minimum[k] = point[k] < minimum[k] ? point[k] : minimum[k];
+            maximum[k] = point[k] > maximum[k] ? point[k] : maximum[k];
+        }
+    }
+    void include(const MeshBounds& other)
+    {
+        include(other.minimum);
+        include(other.maximum);
+    }
+};
+
+// an indexed triangle list in CPU memory
+struct MeshData
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<GLuint> indices;
+    MeshBounds bounds;
+    bool hasTexCoords = false;
+    bool computedNormals = false;    // the file had none; they are smoothed face normals
+};
+
+// an indexed triangle list in GL buffers, laid out as MeshVertexLayout
+struct MeshBuffers
+{
+    GLuint vertexArray = 0, vertexBuffer = 0, indexBuffer = 0;
+    GLsizei vertexCount = 0, indexCount = 0;
+    MeshBounds bounds;
+
+    void draw(GLenum mode = GL_TRIANGLES) const
+    {
+        glBindVertexArray(vertexArray);
+        glDrawElements(mode, indexCount, GL_UNSIGNED_INT, nullptr);
+        glBindVertexArray(0);
+    }
+    void destroy()
+    {
+        glDeleteBuffers(1, &indexBuffer);
+        glDeleteBuffers(1, &vertexBuffer);
+        glDeleteVertexArrays(1, &vertexArray);
+        vertexArray = vertexBuffer = indexBuffer = 0;
+        vertexCount = indexCount = 0;
+    }
+};
+
+
+namespace mesh_loader {
+
+const uint32_t NONE = 0xFFFFFFFFu;
+
+// A read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                bytes = static_cast<const char*>(mapping);
+                length = (size_t)info.st_size;
+                madvise(mapping, length, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile()
+    {
+        if (bytes != nullptr)
+            munmap(const_cast<char*>(bytes), length);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return bytes != nullptr; }
+    const char* begin() const { return bytes; }
+    const char* end() const { return bytes + length; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+};
+
+// runs work(0) ... work(count - 1), each on its own thread
+template <typename Work>
+void parallel(size_t count, Work work)
+{
+    if (count == 1)
+    {
+        work((size_t)0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < count; ++i)
+        workers.emplace_back(work, i);
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+// [begin, end) cut into pieces that end on line boundaries
+inline std::vector<const char*> splitLines(const char* begin, const char* end, size_t pieces)
+{
+    std::vector<const char*> cuts(1, begin);
+    for (size_t i = 1; i < pieces; ++i)
+    {
+        const char* at = begin + (size_t)(end - begin) * i / pieces;
+        if (at < cuts.back())
+            at = cuts.back();
+        const char* newline = static_cast<const char*>(std::memchr(at, '\n', (size_t)(end - at)));
+        cuts.push_back(newline != nullptr ? newline + 1 : end);
+    }
+    cuts.push_back(end);
+    return cuts;
+}
+
+inline const char* lineEnd(const char* at, const char* end)
+{
+    const char* newline = static_cast<const char*>(std::memchr(at, '\n', (size_t)(end - at)));
+    return newline != nullptr ? newline : end;
+}
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char* skipBlanks(const char* at, const char* end)
+{
+    while (at < end && isBlank(*at))
+        ++at;
+    return at;
+}
+
+// decimal float parser for the common forms (1, -1.5, .5, 2e-3); returns the character after
+// the number, or nullptr if there is none. Up to 19 significant digits are kept and scaled by
+// an exact power of ten, which is what float precision needs and several times faster than strtof.
+inline const char* parseFloat(const char* at, const char* end, float& value)
+{
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    at = skipBlanks(at, end);
+    bool negative = false;
+    if (at < end && (*at == '-' || *at == '+'))
+        negative = *at++ == '-';
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; at < end && (unsigned)(*at - '0') < 10; ++at, any = true)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (uint64_t)(*at - '0');
+            digits += mantissa != 0;
+        }
+        else
+            ++exponent;
+    }
+    if (at < end && *at == '.')
+        for (++at; at < end && (unsigned)(*at - '0') < 10; ++at, any = true)
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (uint64_t)(*at - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+    if (!any)
+        return nullptr;
+    if (at + 1 < end && (*at == 'e' || *at == 'E'))
+    {
+        const char* power = at + 1;
+        bool negativePower = false;
+        if (*power == '-' || *power == '+')
+            negativePower = *power++ == '-';
+        if (power < end && (unsigned)(*power - '0') < 10)
+        {
+            int explicitExponent = 0;
+            for (; power < end && (unsigned)(*power - '0') < 10; ++power)
+                explicitExponent = explicitExponent < 10000 ? explicitExponent * 10 + (*power - '0') : explicitExponent;
+            exponent += negativePower ? -explicitExponent : explicitExponent;
+            at = power;
+        }
+    }
+    double result = (double)mantissa;
+    if (exponent < 0)
+        result = exponent >= -22 ? result / powers[-exponent] : result * std::pow(10.0, exponent);
+    else if (exponent > 0)
+        result = exponent <= 22 ? result * powers[exponent] : result * std::pow(10.0, exponent);
+    value = (float)(negative ? -result : result);
+    return at;
+}
+
+inline const char* parseInt(const char* at, const char* end, int64_t& value)
+{
+    at = skipBlanks(at, end);
+    bool negative = false;
+    if (at < end && (*at == '-' || *at == '+'))
+        negative = *at++ == '-';
+    if (at >= end || (unsigned)(*at - '0') >= 10)
+        return nullptr;
+    int64_t result = 0;
+    for (; at < end && (unsigned)(*at - '0') < 10; ++at)
+        result = result < ((int64_t)1 << 40) ? result * 10 + (*at - '0') : result;
+    value = negative ? -result : result;
+    return at;
+}
+
+// Open-addressing hash set of keys stored elsewhere: the table keeps only 32-bit ids into the
+// key vector, probes linearly and stays at most half full. insert() returns the id of an
+// equal key, or appends the new key and returns its id. Keys compare bytewise.
+template <typename Key>
+class DedupTable
+{
+public:
+    static_assert(sizeof(Key) % 4 == 0, "dedup keys are hashed as 32-bit words");
+
+    explicit DedupTable(size_t expected)
+    {
+        size_t capacity = 1024;
+        while (capacity < expected * 2)
+            capacity *= 2;
+        slots.assign(capacity, NONE);
+    }
+
+    uint32_t insert(const Key& key, std::vector<Key>& keys)
+    {
+        if ((keys.size() + 1) * 2 > slots.size())
+            rehash(keys);
+        size_t mask = slots.size() - 1;
+        for (size_t at = hash(key) & mask;; at = (at + 1) & mask)
+        {
+            uint32_t id = slots[at];
+            if (id == NONE)
+            {
+                id = (uint32_t)keys.size();
+                slots[at] = id;
+                keys.push_back(key);
+                return id;
+            }
+            if (std::memcmp(&keys[id], &key, sizeof(Key)) == 0)
+                return id;
+        }
+    }
+
+    size_t bytes() const { return slots.capacity() * sizeof(uint32_t); }
+
+private:
+    std::vector<uint32_t> slots;
+
+    static size_t hash(const Key& key)
+    {
+        uint32_t words[sizeof(Key) / 4];
+        std::memcpy(words, &key, sizeof(Key));
+        uint64_t result = 0x9E3779B97F4A7C15ull;
+        for (uint32_t word : words)
+            result = (result ^ word) * 0xFF51AFD7ED558CCDull;
+        return (size_t)(result ^ (result >> 32));
+    }
+
+    void rehash(const std::vector<Key>& keys)
+    {
+        slots.assign(slots.size() * 2, NONE);
+        size_t mask = slots.size() - 1;
+        for (uint32_t id = 0; id < (uint32_t)keys.size(); ++id)
+        {
+            size_t at = hash(keys[id]) & mask;
+            while (slots[at] != NONE)
+                at = (at + 1) & mask;
+            slots[at] = id;
+        }
+    }
+};
+
+} // namespace mesh_loader
+
+
+/*
+   Loads Wavefront OBJ and PLY (ascii or binary) triangle meshes into an indexed MeshData or
+   straight into GL buffers:
+
+       MeshLoader loader;                        // one worker per core
+       MeshBuffers bunny;
+       if (loader.load("bunny.obj", bunny))
+       {
+           loader.printStats();
+           bunny.draw();
+       }
+
+   The file is memory-mapped and cut into line-aligned chunks that are parsed in parallel,
+   one thread per chunk, with a number parser that never allocates. Vertices that repeat
+   (an OBJ position/texcoord/normal triple used by several faces, or identical PLY vertices)
+   are merged through an open-addressing hash table, which yields the index buffer; polygons
+   are triangulated as fans. Files without normals get smooth ones from the faces.
+
+   Loading into MeshBuffers writes the indices and the vertices directly into mapped GL
+   buffers, so the interleaved mesh is never held in CPU memory as well. OBJ materials,
+   groups, lines and points are ignored. All GL calls happen on the calling thread.
+ */
+class MeshLoader
+{
+public:
+    struct Stats
+    {
+        size_t fileBytes = 0;
+        size_t corners = 0;             // triangle corners read, before deduplication
+        size_t vertices = 0;
+        size_t triangles = 0;
+        unsigned threads = 0;
+        double parseMilliseconds = 0;   // mapping and parsing, in parallel
+        double dedupMilliseconds = 0;   // hashing corners into the index buffer
+        double gatherMilliseconds = 0;  // writing out unique vertices, in parallel
+        double uploadMilliseconds = 0;  // allocating, mapping and unmapping GL buffers
+        double totalMilliseconds = 0;
+        size_t workingBytes = 0;        // loader memory at its peak, beside the mapped file
+        size_t peakResidentBytes = 0;   // of the whole process, so far
+    };
+
+    explicit MeshLoader(unsigned threads = 0)
+    {
+        workers = threads != 0 ? threads : std::thread::hardware_concurrency();
+        workers = workers == 0 ? 4 : workers;
+    }
+
+    // return false (after printing why) if the file cannot be read or is malformed
+    // ------------------------------------------------------------------------
+    bool load(const std::string& path, MeshData& mesh)
+    {
+        DataTarget target(mesh);
+        return run(path, target);
+    }
+
+    // creates the GL objects if they are 0; the vertex array is left configured with
+    // MeshVertexLayout and the index buffer. The caller deletes them with destroy().
+    // ------------------------------------------------------------------------
+    bool load(const std::string& path, MeshBuffers& buffers)
+    {
+        BufferTarget target(buffers);
+        return run(path, target);
+    }
+
+    // copies a mesh loaded into memory (or built some other way) into GL buffers
+    static void upload(const MeshData& mesh, MeshBuffers& buffers)
+    {
+        BufferTarget::create(buffers);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(mesh.vertices.size() * sizeof(MeshVertex)), mesh.vertices.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(mesh.indices.size() * sizeof(GLuint)), mesh.indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+        buffers.vertexCount = (GLsizei)mesh.vertices.size();
+        buffers.indexCount = (GLsizei)mesh.indices.size();
+        buffers.bounds = mesh.bounds;
+    }
+
+    const Stats& stats() const { return lastStats; }
+
+    void printStats() const
+    {
+        const double megabyte = 1024.0 * 1024.0;
+        const Stats& s = lastStats;
+        std::cout << std::fixed << std::setprecision(1)
+                  << "MESH_LOADER " << s.fileBytes / megabyte << " MB: " << s.vertices << " vertices, " << s.triangles
+                  << " triangles (" << s.corners << " corners) in " << s.totalMilliseconds << " ms on " << s.threads << " threads\n"
+                  << "MESH_LOADER parse: " << s.parseMilliseconds << " ms dedup: " << s.dedupMilliseconds
+                  << " ms gather: " << s.gatherMilliseconds << " ms upload: " << s.uploadMilliseconds << " ms\n"
+                  << "MESH_LOADER working set: " << s.workingBytes / megabyte << " MB peak RSS: " << s.peakResidentBytes / megabyte << " MB"
+                  << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    enum { POSITION, TEXCOORD, NORMAL };
+
+    // an OBJ face corner: position, texcoord and normal numbers, NONE where absent
+    struct Corner
+    {
+        uint32_t attribute[3];
+    };
+
+    struct ObjChunk
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        const char* error = nullptr;
+        std::vector<float> positions, texCoords, normals;
+        std::vector<Corner> corners;
+        std::vector<size_t> relative;    // corner components holding chunk-relative (negative) references
+        uint32_t base[3] = { 0, 0, 0 };
+    };
+
+    struct PlyProperty
+    {
+        std::string name;
+        int type = 0;
+        int countType = -1;              // list length type, -1 for scalars
+        int field = -1;                  // float index into a MeshVertex, for vertex properties
+    };
+    struct PlyElement
+    {
+        std::string name;
+        size_t count = 0;
+        size_t firstLine = 0;            // ascii
+        std::vector<PlyProperty> properties;
+    };
+    struct PlyFaces
+    {
+        std::vector<uint32_t> indices;
+        const char* error = nullptr;
+    };
+
+    // MeshData as the destination
+    class DataTarget
+    {
+    public:
+        explicit DataTarget(MeshData& mesh) : mesh(mesh) {}
+        GLuint* indices(size_t count) { mesh.indices.resize(count); return mesh.indices.data(); }
+        bool indicesDone() { return true; }
+        MeshVertex* vertices(size_t count) { mesh.vertices.resize(count); return mesh.vertices.data(); }
+        bool verticesDone() { return true; }
+        void describe(const MeshBounds& bounds, bool texCoords, bool computedNormals)
+        {
+            mesh.bounds = bounds;
+            mesh.hasTexCoords = texCoords;
+            mesh.computedNormals = computedNormals;
+        }
+        void fail() { mesh.vertices.clear(); mesh.indices.clear(); }
+    private:
+        MeshData& mesh;
+    };
+
+    // GL buffers as the destination, written through glMapBufferRange
+    class BufferTarget
+    {
+    public:
+        explicit BufferTarget(MeshBuffers& buffers) : buffers(buffers) { create(buffers); }
+        GLuint* indices(size_t count)
+        {
+            buffers.indexCount = (GLsizei)count;
+            return static_cast<GLuint*>(map(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint)));
+        }
+        bool indicesDone() { return unmap(GL_ELEMENT_ARRAY_BUFFER); }
+        MeshVertex* vertices(size_t count)
+        {
+            buffers.vertexCount = (GLsizei)count;
+            return static_cast<MeshVertex*>(map(GL_ARRAY_BUFFER, count * sizeof(MeshVertex)));
+        }
+        bool verticesDone() { return unmap(GL_ARRAY_BUFFER); }
+        void describe(const MeshBounds& bounds, bool, bool) { buffers.bounds = bounds; }
+        void fail() { buffers.vertexCount = buffers.indexCount = 0; glBindVertexArray(0); }
+
+        double milliseconds = 0;
+
+        static void create(MeshBuffers& buffers)
+        {
+            if (buffers.vertexArray == 0)
+                glGenVertexArrays(1, &buffers.vertexArray);
+            if (buffers.vertexBuffer == 0)
+                glGenBuffers(1, &buffers.vertexBuffer);
+            if (buffers.indexBuffer == 0)
+                glGenBuffers(1, &buffers.indexBuffer);
+            MeshVertexLayout::configure(buffers.vertexArray, buffers.vertexBuffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+        }
+
+    private:
+        MeshBuffers& buffers;
+
+        void* map(GLenum target, size_t bytes)
+        {
+            Clock::time_point start = Clock::now();
+            glBindVertexArray(buffers.vertexArray);
+            glBindBuffer(target, target == GL_ARRAY_BUFFER ? buffers.vertexBuffer : buffers.indexBuffer);
+            glBufferData(target, (GLsizeiptr)bytes, nullptr, GL_STATIC_DRAW);
+            void* memory = bytes > 0 ? glMapBufferRange(target, 0, (GLsizeiptr)bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) : nullptr;
+            if (memory == nullptr && bytes > 0)
+                std::cout << "ERROR::MESH_LOADER::MAP_FAILED " << bytes << " bytes" << std::endl;
+            milliseconds += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            return memory;
+        }
+        bool unmap(GLenum target)
+        {
+            Clock::time_point start = Clock::now();
+            bool intact = glUnmapBuffer(target) == GL_TRUE;
+            if (target == GL_ARRAY_BUFFER)
+                glBindVertexArray(0);
+            if (!intact)
+                std::cout << "ERROR::MESH_LOADER::UNMAP_FAILED buffer contents were lost" << std::endl;
+            milliseconds += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            return intact;
+        }
+    };
+
+    unsigned workers;
+    Stats lastStats;
+
+    static double since(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    static size_t peakResident()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#ifdef __APPLE__
+        return (size_t)usage.ru_maxrss;
+#else
+        return (size_t)usage.ru_maxrss * 1024;
+#endif
+    }
+
+    // roughly 1 MB of text per chunk, at most one chunk per worker
+    size_t chunkCount(size_t bytes) const
+    {
+        size_t chunks = bytes / (1 << 20) + 1;
+        return chunks < workers ? chunks : workers;
+    }
+
+    static bool endsWith(const std::string& text, const char* suffix)
+    {
+        size_t length = std::strlen(suffix);
+        if (text.size() < length)
+            return false;
+        for (size_t i = 0; i < length; ++i)
+            if (std::tolower((unsigned char)text[text.size() - length + i]) != suffix[i])
+                return false;
+        return true;
+    }
+
+    template <typename Target>
+    bool run(const std::string& path, Target& target)
+    {
+        lastStats = Stats();
+        Clock::time_point start = Clock::now();
+        mesh_loader::MappedFile file(path);
+        if (!file.valid())
+        {
+            std::cout << "ERROR::MESH_LOADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+            target.fail();
+            return false;
+        }
+        lastStats.fileBytes = file.size();
+        bool loaded;
+        if (endsWith(path, ".obj"))
+            loaded = loadObj(path, file, target);
+        else if (endsWith(path, ".ply"))
+            loaded = loadPly(path, file, target);
+        else
+        {
+            std::cout << "ERROR::MESH_LOADER::UNKNOWN_FORMAT " << path << " (expected .obj or .ply)" << std::endl;
+            loaded = false;
+        }
+        if (!loaded)
+            target.fail();
+        lastStats.uploadMilliseconds = uploadTime(target);
+        lastStats.totalMilliseconds = since(start);
+        lastStats.peakResidentBytes = peakResident();
+        return loaded;
+    }
+
+    static double uploadTime(DataTarget&) { return 0.0; }
+    static double uploadTime(BufferTarget& target) { return target.milliseconds; }
+
+    static size_t lineNumber(const mesh_loader::MappedFile& file, const char* at)
+    {
+        size_t line = 1;
+        for (const char* p = file.begin(); p < at; ++p)
+            line += *p == '\n';
+        return line;
+    }
+
+    // smooth normals: area-weighted face normals summed at each position, not yet normalized
+    static void accumulateNormal(float* normals, const float* a, const float* b, const float* c, uint32_t ia, uint32_t ib, uint32_t ic)
+    {
+        float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+        for (int k = 0; k < 3; ++k)
+        {
+            normals[ia * 3 + (uint32_t)k] += n[k];
+            normals[ib * 3 + (uint32_t)k] += n[k];
+            normals[ic * 3 + (uint32_t)k] += n[k];
+        }
+    }
+
+    static void normalize(const float* in, float* out)
+    {
+        float length = std::sqrt(in[0] * in[0] + in[1] * in[1] + in[2] * in[2]);
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        out[0] = in[0] * scale;
+        out[1] = in[1] * scale;
+        out[2] = in[2] * scale;
+    }
+
+
+    // OBJ
+    // ------------------------------------------------------------------------
+    static void parseObj(ObjChunk& chunk)
+    {
+        using namespace mesh_loader;
+        Corner first = {}, previous = {};
+        int firstRelative = 0, previousRelative = 0;
+        auto push = [&chunk](const Corner& corner, int relative) {
+            for (size_t k = 0; k < 3; ++k)
+                if (relative & (1 << k))
+                    chunk.relative.push_back(chunk.corners.size() * 3 + k);
+            chunk.corners.push_back(corner);
+        };
+
+        for (const char* line = chunk.begin; line < chunk.end; )
+        {
+            const char* end = lineEnd(line, chunk.end);
+            const char* at = skipBlanks(line, end);
+            bool ok = true;
+            if (end - at >= 2 && at[0] == 'v' && isBlank(at[1]))
+            {
+                float xyz[3];
+                for (int k = 0; k < 3 && ok; ++k)
+                    ok = (at = parseFloat(at + (k == 0 ? 1 : 0), end, xyz[k])) != nullptr;
+                chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+            }
+            else if (end - at >= 3 && at[0] == 'v' && at[1] == 't' && isBlank(at[2]))
+            {
+                float uv[2] = { 0.0f, 0.0f };
+                ok = (at = parseFloat(at + 2, end, uv[0])) != nullptr;
+                if (ok && skipBlanks(at, end) < end)
+                    ok = parseFloat(at, end, uv[1]) != nullptr;
+                chunk.texCoords.insert(chunk.texCoords.end(), uv, uv + 2);
+            }
+            else if (end - at >= 3 && at[0] == 'v' && at[1] == 'n' && isBlank(at[2]))
+            {
+                float xyz[3];
+                for (int k = 0; k < 3 && ok; ++k)
+                    ok = (at = parseFloat(at + (k == 0 ? 2 : 0), end, xyz[k])) != nullptr;
+                chunk.normals.insert(chunk.normals.end(), xyz, xyz + 3);
+            }
+            else if (end - at >= 2 && at[0] == 'f' && isBlank(at[1]))
+            {
+                // "f v v v", "f v/t ...", "f v//n ...", "f v/t/n ..."; a negative number counts
+                // back from the last one read, which for now is only known within the chunk
+                const size_t counts[3] = { chunk.positions.size() / 3, chunk.texCoords.size() / 2, chunk.normals.size() / 3 };
+                int corners = 0;
+                at = skipBlanks(at + 1, end);
+                while (ok && at < end)
+                {
+                    Corner corner = { { NONE, NONE, NONE } };
+                    int relative = 0;
+                    for (int k = 0; k < 3 && ok; ++k)
+                    {
+                        if (k > 0)
+                        {
+                            if (at >= end || *at != '/')
+                                break;
+                            ++at;
+                            if (k == 1 && at < end && *at == '/')
+                                continue;
+                        }
+                        int64_t number;
+                        ok = (at = parseInt(at, end, number)) != nullptr && number != 0;
+                        if (!ok)
+                            break;
+                        if (number > 0)
+                            corner.attribute[k] = (uint32_t)(number - 1);
+                        else
+                        {
+                            corner.attribute[k] = (uint32_t)((int64_t)counts[k] + number);
+                            relative |= 1 << k;
+                        }
+                    }
+                    if (!ok || (at < end && !isBlank(*at)))
+                    {
+                        ok = false;
+                        break;
+                    }
+                    if (corners == 0)
+                    {
+                        first = corner;
+                        firstRelative = relative;
+                    }
+                    else if (corners >= 2)
+                    {
+                        push(first, firstRelative);
+                        push(previous, previousRelative);
+                        push(corner, relative);
+                    }
+                    previous = corner;
+                    previousRelative = relative;
+                    ++corners;
+                    at = skipBlanks(at, end);
+                }
+            }
+            if (!ok)
+            {
+                chunk.error = line;
+                return;
+            }
+            line = end + 1;
+        }
+    }
+
+    template <typename Target>
+    bool loadObj(const std::string& path, const mesh_loader::MappedFile& file, Target& target)
+    {
+        using namespace mesh_loader;
+        Clock::time_point start = Clock::now();
+        std::vector<const char*> cuts = splitLines(file.begin(), file.end(), chunkCount(file.size()));
+        std::vector<ObjChunk> chunks(cuts.size() - 1);
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            chunks[i].begin = cuts[i];
+            chunks[i].end = cuts[i + 1];
+        }
+        lastStats.threads = (unsigned)chunks.size();
+        parallel(chunks.size(), [&chunks](size_t i) { parseObj(chunks[i]); });
+
+        uint32_t totals[3] = { 0, 0, 0 };
+        for (ObjChunk& chunk : chunks)
+        {
+            if (chunk.error != nullptr)
+            {
+                std::cout << "ERROR::MESH_LOADER::PARSE_FAILED " << path << ":" << lineNumber(file, chunk.error) << std::endl;
+                return false;
+            }
+            for (int k = 0; k < 3; ++k)
+                chunk.base[k] = totals[k];
+            totals[POSITION] += (uint32_t)(chunk.positions.size() / 3);
+            totals[TEXCOORD] += (uint32_t)(chunk.texCoords.size() / 2);
+            totals[NORMAL] += (uint32_t)(chunk.normals.size() / 3);
+            lastStats.corners += chunk.corners.size();
+        }
+
+        // make relative references absolute, check every reference, and gather the attribute
+        // arrays into one place for random access
+        std::vector<float> positions((size_t)totals[POSITION] * 3), texCoords((size_t)totals[TEXCOORD] * 2), normals((size_t)totals[NORMAL] * 3);
+        std::vector<char> valid(chunks.size(), 1);
+        parallel(chunks.size(), [&](size_t i) {
+            ObjChunk& chunk = chunks[i];
+            for (size_t slot : chunk.relative)
+                chunk.corners[slot / 3].attribute[slot % 3] += chunk.base[slot % 3];
+            for (const Corner& corner : chunk.corners)
+                for (int k = 0; k < 3; ++k)
+                    if (corner.attribute[k] != NONE && corner.attribute[k] >= totals[k])
+                        valid[i] = 0;
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + (ptrdiff_t)chunk.base[POSITION] * 3);
+            std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + (ptrdiff_t)chunk.base[TEXCOORD] * 2);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + (ptrdiff_t)chunk.base[NORMAL] * 3);
+            std::vector<float>().swap(chunk.positions);
+            std::vector<float>().swap(chunk.texCoords);
+            std::vector<float>().swap(chunk.normals);
+        });
+        for (size_t i = 0; i < chunks.size(); ++i)
+            if (!valid[i])
+            {
+                std::cout << "ERROR::MESH_LOADER::BAD_INDEX a face in " << path << " refers to a vertex that does not exist" << std::endl;
+                return false;
+            }
+        lastStats.parseMilliseconds = since(start);
+
+        // without normals in the file, each position gets the sum of its faces' normals
+        // and the corners are merged on position and texcoord alone
+        start = Clock::now();
+        bool computeNormals = totals[NORMAL] == 0;
+        std::vector<float> smoothNormals;
+        if (computeNormals)
+        {
+            smoothNormals.assign(positions.size(), 0.0f);
+            for (const ObjChunk& chunk : chunks)
+                for (size_t c = 0; c + 2 < chunk.corners.size(); c += 3)
+                {
+                    uint32_t a = chunk.corners[c].attribute[POSITION], b = chunk.corners[c + 1].attribute[POSITION], d = chunk.corners[c + 2].attribute[POSITION];
+                    accumulateNormal(smoothNormals.data(), &positions[a * 3], &positions[b * 3], &positions[d * 3], a, b, d);
+                }
+        }
+
+        GLuint* indices = target.indices(lastStats.corners);
+        if (indices == nullptr && lastStats.corners > 0)
+            return false;
+        std::vector<Corner> unique;
+        unique.reserve(lastStats.corners / 4);
+        DedupTable<Corner> table(lastStats.corners / 4);
+        size_t written = 0;
+        for (const ObjChunk& chunk : chunks)
+            for (const Corner& corner : chunk.corners)
+                indices[written++] = table.insert(corner, unique);
+        lastStats.workingBytes = table.bytes() + unique.capacity() * sizeof(Corner) + (positions.capacity() + texCoords.capacity() + normals.capacity() + smoothNormals.capacity()) * sizeof(float);
+        for (const ObjChunk& chunk : chunks)
+            lastStats.workingBytes += chunk.corners.capacity() * sizeof(Corner) + chunk.relative.capacity() * sizeof(size_t);
+        bool intact = target.indicesDone();
+        lastStats.dedupMilliseconds = since(start);
+        if (!intact)
+            return false;
+
+        start = Clock::now();
+        MeshVertex* vertices = target.vertices(unique.size());
+        if (vertices == nullptr && !unique.empty())
+            return false;
+        std::vector<MeshBounds> bounds(chunks.size());
+        parallel(chunks.size(), [&](size_t i) {
+            size_t first = unique.size() * i / chunks.size(), last = unique.size() * (i + 1) / chunks.size();
+            for (size_t v = first; v < last; ++v)
+            {
+                const Corner& corner = unique[v];
+                MeshVertex vertex = {};
+                std::memcpy(vertex.position, &positions[(size_t)corner.attribute[POSITION] * 3], 3 * sizeof(float));
+                if (computeNormals)
+                    normalize(&smoothNormals[(size_t)corner.attribute[POSITION] * 3], vertex.normal);
+                else if (corner.attribute[NORMAL] != NONE)
+                    std::memcpy(vertex.normal, &normals[(size_t)corner.attribute[NORMAL] * 3], 3 * sizeof(float));
+                if (corner.attribute[TEXCOORD] != NONE)
+                    std::memcpy(vertex.texCoord, &texCoords[(size_t)corner.attribute[TEXCOORD] * 2], 2 * sizeof(float));
+                vertices[v] = vertex;
+                bounds[i].include(vertex.position);
+            }
+        });
+        intact = target.verticesDone();
+        lastStats.gatherMilliseconds = since(start);
+        lastStats.vertices = unique.size();
+        lastStats.triangles = lastStats.corners / 3;
+        for (size_t i = 1; i < bounds.size(); ++i)
+            bounds[0].include(bounds[i]);
+        target.describe(bounds[0], totals[TEXCOORD] > 0, computeNormals);
+        return intact;
+    }
+
+
+    // PLY
+    // ------------------------------------------------------------------------
+    enum PlyType { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, PLY_TYPES };
+
+    static int plyType(const std::string& name)
+    {
+        static const char* names[][2] = { { "char", "int8" }, { "uchar", "uint8" }, { "short", "int16" }, { "ushort", "uint16" },
+                                          { "int", "int32" }, { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" } };
+        for (int type = 0; type < PLY_TYPES; ++type)
+            if (name == names[type][0] || name == names[type][1])
+                return type;
+        return -1;
+    }
+
+    static size_t plySize(int type)
+    {
+        static const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+        return sizes[type];
+    }
+
+    static double readBinary(const char* at, int type, bool swap)
+    {
+        unsigned char bytes[8];
+        size_t size = plySize(type);
+        for (size_t i = 0; i < size; ++i)
+            bytes[i] = (unsigned char)at[swap ? size - 1 - i : i];
+        switch (type)
+        {
+            case INT8: { int8_t v; std::memcpy(&v, bytes, 1); return v; }
+            case UINT8: return bytes[0];
+            case INT16: { int16_t v; std::memcpy(&v, bytes, 2); return v; }
+            case UINT16: { uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+            case INT32: { int32_t v; std::memcpy(&v, bytes, 4); return v; }
+            case UINT32: { uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+            case FLOAT32: { float v; std::memcpy(&v, bytes, 4); return v; }
+            default: { double v; std::memcpy(&v, bytes, 8); return v; }
+        }
+    }
+
+    // where each vertex property goes in a MeshVertex, as a float index, or -1
+    static int plyField(const std::string& name)
+    {
+        static const char* names[][3] = { { "x", "", "" }, { "y", "", "" }, { "z", "", "" },
+                                          { "nx", "", "" }, { "ny", "", "" }, { "nz", "", "" },
+                                          { "u", "s", "texture_u" }, { "v", "t", "texture_v" } };
+        for (int field = 0; field < 8; ++field)
+            for (const char* candidate : names[field])
+                if (*candidate != '\0' && name == candidate)
+                    return field;
+        if (name == "texture_s")
+            return 6;
+        if (name == "texture_t")
+            return 7;
+        return -1;
+    }
+
+    static bool isFaceList(const PlyProperty& property)
+    {
+        return property.countType >= 0 && (property.name == "vertex_indices" || property.name == "vertex_index");
+    }
+
+    // appends the fan triangulation of one polygon
+    static void fan(std::vector<uint32_t>& out, const uint32_t* polygon, size_t count)
+    {
+        for (size_t i = 2; i < count; ++i)
+        {
+            out.push_back(polygon[0]);
+            out.push_back(polygon[i - 1]);
+            out.push_back(polygon[i]);
+        }
+    }
+
+    template <typename Target>
+    bool loadPly(const std::string& path, const mesh_loader::MappedFile& file, Target& target)
+    {
+        using namespace mesh_loader;
+        Clock::time_point start = Clock::now();
+
+        // header
+        enum { ASCII, LITTLE, BIG } format = ASCII;
+        std::vector<PlyElement> elements;
+        const char* at = file.begin();
+        bool magic = false, ended = false;
+        while (at < file.end() && !ended)
+        {
+            const char* end = lineEnd(at, file.end());
+            std::string line(at, (size_t)(end - at));
+            at = end < file.end() ? end + 1 : end;
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+                line.pop_back();
+            std::vector<std::string> words;
+            for (size_t word = line.find_first_not_of(' '); word != std::string::npos; word = line.find_first_not_of(' ', word))
+            {
+                size_t stop = line.find(' ', word);
+                words.push_back(line.substr(word, stop == std::string::npos ? std::string::npos : stop - word));
+                word = stop;
+            }
+            if (!magic)
+            {
+                if (words.size() != 1 || words[0] != "ply")
+                    break;
+                magic = true;
+            }
+            else if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+                continue;
+            else if (words[0] == "format" && words.size() >= 2)
+                format = words[1] == "ascii" ? ASCII : words[1] == "binary_big_endian" ? BIG : LITTLE;
+            else if (words[0] == "element" && words.size() == 3)
+            {
+                PlyElement element;
+                element.name = words[1];
+                element.count = (size_t)std::strtoull(words[2].c_str(), nullptr, 10);
+                elements.push_back(element);
+            }
+            else if (words[0] == "property" && !elements.empty())
+            {
+                PlyProperty property;
+                if (words.size() == 5 && words[1] == "list")
+                {
+                    property.countType = plyType(words[2]);
+                    property.type = plyType(words[3]);
+                    property.name = words[4];
+                    if (property.countType < 0)
+                        property.type = -1;
+                }
+                else if (words.size() == 3)
+                {
+                    property.type = plyType(words[1]);
+                    property.name = words[2];
+                }
+                else
+                    property.type = -1;
+                if (property.type < 0)
+                {
+                    std::cout << "ERROR::MESH_LOADER::BAD_PLY_HEADER " << path << ": " << line << std::endl;
+                    return false;
+                }
+                elements.back().properties.push_back(property);
+            }
+            else if (words[0] == "end_header")
+                ended = true;
+        }
+        if (!magic || !ended)
+        {
+            std::cout << "ERROR::MESH_LOADER::BAD_PLY_HEADER " << path << std::endl;
+            return false;
+        }
+
+        // an element takes at least one byte of the body, a line in ascii, or its fixed-size
+        // fields and list counts in binary; counts the rest of the file cannot hold are
+        // rejected before anything is allocated for them
+        size_t remaining = (size_t)(file.end() - at);
+        for (const PlyElement& element : elements)
+        {
+            size_t rowSize = 0;
+            if (format != ASCII)
+                for (const PlyProperty& property : element.properties)
+                    rowSize += plySize(property.countType < 0 ? property.type : property.countType);
+            rowSize = std::max(rowSize, (size_t)1);
+            if (element.count > remaining / rowSize)
+            {
+                std::cout << "ERROR::MESH_LOADER::BAD_PLY_HEADER " << path << ": " << element.count << " " << element.name << " elements do not fit in the file" << std::endl;
+                return false;
+            }
+            remaining -= element.count * rowSize;
+        }
+
+        PlyElement* vertexElement = nullptr;
+        const PlyElement* faceElement = nullptr;
+        size_t line = 0;
+        for (PlyElement& element : elements)
+        {
+            element.firstLine = line;
+            line += element.count;
+            if (element.name == "vertex")
+                vertexElement = &element;
+            else if (element.name == "face")
+                faceElement = &element;
+        }
+        if (vertexElement == nullptr || faceElement == nullptr)
+        {
+            std::cout << "ERROR::MESH_LOADER::BAD_PLY_HEADER " << path << " has no vertex or no face element" << std::endl;
+            return false;
+        }
+
+        bool fields[8] = {};
+        for (PlyProperty& property : vertexElement->properties)
+            if (property.countType < 0 && (property.field = plyField(property.name)) >= 0)
+                fields[property.field] = true;
+        bool hasNormals = fields[3] && fields[4] && fields[5];
+        bool hasTexCoords = fields[6] && fields[7];
+
+        std::vector<MeshVertex> plyVertices(vertexElement->count, MeshVertex());
+        std::vector<PlyFaces> faces;
+        const char* error = nullptr;
+        if (format == ASCII)
+        {
+            if (!parsePlyAscii(at, file.end(), elements, vertexElement, faceElement, plyVertices, faces, error))
+            {
+                if (error == nullptr)
+                    std::cout << "ERROR::MESH_LOADER::PARSE_FAILED " << path << " ends early" << std::endl;
+                else
+                    std::cout << "ERROR::MESH_LOADER::PARSE_FAILED " << path << ":" << lineNumber(file, error) << std::endl;
+                return false;
+            }
+        }
+        else if (!parsePlyBinary(at, file.end(), format == BIG, elements, vertexElement, faceElement, plyVertices, faces))
+        {
+            std::cout << "ERROR::MESH_LOADER::PARSE_FAILED " << path << " ends early" << std::endl;
+            return false;
+        }
+        for (const PlyFaces& part : faces)
+            lastStats.corners += part.indices.size();
+        for (const PlyFaces& part : faces)
+            for (uint32_t index : part.indices)
+                if (index >= plyVertices.size())
+                {
+                    std::cout << "ERROR::MESH_LOADER::BAD_INDEX a face in " << path << " refers to a vertex that does not exist" << std::endl;
+                    return false;
+                }
+        lastStats.parseMilliseconds = since(start);
+
+        // identical vertices merge; normals are computed after that, so vertices split only
+        // to repeat a position come out smooth
+        start = Clock::now();
+        std::vector<MeshVertex> unique;
+        unique.reserve(plyVertices.size());
+        std::vector<uint32_t> remap(plyVertices.size());
+        {
+            DedupTable<MeshVertex> table(plyVertices.size());
+            for (size_t v = 0; v < plyVertices.size(); ++v)
+                remap[v] = table.insert(plyVertices[v], unique);
+            lastStats.workingBytes = table.bytes() + (plyVertices.capacity() + unique.capacity()) * sizeof(MeshVertex) + remap.capacity() * sizeof(uint32_t);
+            for (const PlyFaces& part : faces)
+                lastStats.workingBytes += part.indices.capacity() * sizeof(uint32_t);
+        }
+        std::vector<MeshVertex>().swap(plyVertices);
+        if (!hasNormals)
+        {
+            std::vector<float> smoothNormals(unique.size() * 3, 0.0f);
+            for (const PlyFaces& part : faces)
+                for (size_t c = 0; c + 2 < part.indices.size(); c += 3)
+                {
+                    uint32_t a = remap[part.indices[c]], b = remap[part.indices[c + 1]], d = remap[part.indices[c + 2]];
+                    accumulateNormal(smoothNormals.data(), unique[a].position, unique[b].position, unique[d].position, a, b, d);
+                }
+            for (size_t v = 0; v < unique.size(); ++v)
+                normalize(&smoothNormals[v * 3], unique[v].normal);
+        }
+        GLuint* indices = target.indices(lastStats.corners);
+        if (indices == nullptr && lastStats.corners > 0)
+            return false;
+        size_t written = 0;
+        for (const PlyFaces& part : faces)
+            for (uint32_t index : part.indices)
+                indices[written++] = remap[index];
+        bool intact = target.indicesDone();
+        lastStats.dedupMilliseconds = since(start);
+        if (!intact)
+            return false;
+
+        start = Clock::now();
+        MeshVertex* vertices = target.vertices(unique.size());
+        if (vertices == nullptr && !unique.empty())
+            return false;
+        size_t pieces = chunkCount(unique.size() * sizeof(MeshVertex));
+        std::vector<MeshBounds> bounds(pieces);
+        parallel(pieces, [&](size_t i) {
+            size_t first = unique.size() * i / pieces, last = unique.size() * (i + 1) / pieces;
+            if (last > first)
+                std::memcpy(vertices + first, unique.data() + first, (last - first) * sizeof(MeshVertex));
+            for (size_t v = first; v < last; ++v)
+                bounds[i].include(unique[v].position);
+        });
+        intact = target.verticesDone();
+        lastStats.gatherMilliseconds = since(start);
+        lastStats.vertices = unique.size();
+        lastStats.triangles = lastStats.corners / 3;
+        for (size_t i = 1; i < bounds.size(); ++i)
+            bounds[0].include(bounds[i]);
+        target.describe(bounds[0], hasTexCoords, !hasNormals);
+        return intact;
+    }
+
+    // one line per element; chunks first count their lines so each knows which elements
+    // its lines belong to, then parse vertices into place and faces into per-chunk lists.
+    // Fewer lines than the header declares fail with error left null
+    bool parsePlyAscii(const char* body, const char* end, const std::vector<PlyElement>& elements, const PlyElement* vertexElement, const PlyElement* faceElement,
+                       std::vector<MeshVertex>& vertices, std::vector<PlyFaces>& faces, const char*& error)
+    {
+        using namespace mesh_loader;
+        if (body > end)
+            body = end;
+        std::vector<const char*> cuts = splitLines(body, end, chunkCount((size_t)(end - body)));
+        size_t chunks = cuts.size() - 1;
+        lastStats.threads = (unsigned)chunks;
+        std::vector<size_t> firstLine(chunks + 1, 0);
+        parallel(chunks, [&](size_t i) {
+            size_t lines = 0;
+            for (const char* at = cuts[i]; at < cuts[i + 1]; at = lineEnd(at, cuts[i + 1]) + 1)
+                ++lines;
+            firstLine[i + 1] = lines;
+        });
+        for (size_t i = 0; i < chunks; ++i)
+            firstLine[i + 1] += firstLine[i];
+        size_t declared = 0;
+        for (const PlyElement& element : elements)
+            declared += element.count;
+        if (firstLine[chunks] < declared)
+            return false;
+
+        faces.assign(chunks, PlyFaces());
+        parallel(chunks, [&](size_t i) {
+            PlyFaces& out = faces[i];
+            std::vector<uint32_t> polygon;
+            size_t line = firstLine[i];
+            for (const char* at = cuts[i]; at < cuts[i + 1]; ++line)
+            {
+                const char* stop = lineEnd(at, cuts[i + 1]);
+                const PlyElement* element = nullptr;
+                for (const PlyElement& candidate : elements)
+                    if (line >= candidate.firstLine && line < candidate.firstLine + candidate.count)
+                        element = &candidate;
+                if (element == vertexElement || element == faceElement)
+                {
+                    float* vertex = element == vertexElement ? &vertices[line - element->firstLine].position[0] : nullptr;
+                    const char* p = at;
+                    for (const PlyProperty& property : element->properties)
+                    {
+                        if (property.countType >= 0)
+                        {
+                            int64_t count, value = 0;
+                            if ((p = parseInt(p, stop, count)) != nullptr && count < 0)
+                                p = nullptr;
+                            if (p == nullptr)
+                                break;
+                            polygon.clear();
+                            for (int64_t k = 0; k < count && p != nullptr; ++k)
+                            {
+                                float number = 0.0f;
+                                p = property.type < FLOAT32 ? parseInt(p, stop, value) : parseFloat(p, stop, number);
+                                polygon.push_back(property.type < FLOAT32 ? (uint32_t)value : (uint32_t)number);
+                            }
+                            if (p != nullptr && element == faceElement && isFaceList(property))
+                                fan(out.indices, polygon.data(), polygon.size());
+                        }
+                        else
+                        {
+                            float value;
+                            if ((p = parseFloat(p, stop, value)) == nullptr)
+                                break;
+                            if (vertex != nullptr && property.field >= 0)
+                                vertex[property.field] = value;
+                        }
+                        if (p == nullptr)
+                            break;
+                    }
+                    if (p == nullptr)
+                    {
+                        out.error = at;
+                        return;
+                    }
+                }
+                at = stop + 1;
+            }
+        });
+        for (const PlyFaces& part : faces)
+            if (part.error != nullptr)
+            {
+                error = part.error;
+                return false;
+            }
+        return true;
+    }
+
+    // fixed-size vertex records convert in parallel; faces, whose size varies, in one pass
+    bool parsePlyBinary(const char* at, const char* end, bool swap, const std::vector<PlyElement>& elements, const PlyElement* vertexElement, const PlyElement* faceElement,
+                        std::vector<MeshVertex>& vertices, std::vector<PlyFaces>& faces)
+    {
+        using namespace mesh_loader;
+        faces.assign(1, PlyFaces());
+        std::vector<uint32_t> polygon;
+        for (const PlyElement& element : elements)
+        {
+            bool fixed = true;
+            size_t recordSize = 0;
+            for (const PlyProperty& property : element.properties)
+            {
+                fixed = fixed && property.countType < 0;
+                recordSize += property.countType < 0 ? plySize(property.type) : 0;
+            }
+            if (fixed)
+            {
+                if ((size_t)(end - at) < recordSize * element.count)
+                    return false;
+                if (&element == vertexElement)
+                {
+                    size_t pieces = chunkCount(recordSize * element.count);
+                    lastStats.threads = (unsigned)pieces;
+                    parallel(pieces, [&](size_t i) {
+                        size_t first = element.count * i / pieces, last = element.count * (i + 1) / pieces;
+                        for (size_t v = first; v < last; ++v)
+                        {
+                            const char* record = at + v * recordSize;
+                            float* vertex = &vertices[v].position[0];
+                            for (const PlyProperty& property : element.properties)
+                            {
+                                if (property.field >= 0)
+                                    vertex[property.field] = (float)readBinary(record, property.type, swap);
+                                record += plySize(property.type);
+                            }
+                        }
+                    });
+                }
+                at += recordSize * element.count;
+                continue;
+            }
+            for (size_t item = 0; item < element.count; ++item)
+                for (const PlyProperty& property : element.properties)
+                {
+                    if (property.countType < 0)
+                    {
+                        if (at + plySize(property.type) > end)
+                            return false;
+                        at += plySize(property.type);
+                        continue;
+                    }
+                    if (at + plySize(property.countType) > end)
+                        return false;
+                    size_t count = (size_t)readBinary(at, property.countType, swap);
+                    at += plySize(property.countType);
+                    size_t size = plySize(property.type);
+                    if ((size_t)(end - at) < count * size)
+                        return false;
+                    if (&element == faceElement && isFaceList(property))
+                    {
+                        polygon.resize(count);
+                        for (size_t k = 0; k < count; ++k)
+                            polygon[k] = (uint32_t)readBinary(at + k * size, property.type, swap);
+                        fan(faces[0].indices, polygon.data(), count);
+                    }
+                    at += count * size;
+                }
+        }
+        return true;
+    }
+};
+
+#endif /* MeshLoader_h */
@@ -0,0 +1,389 @@
+//
+//  MeshLod.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <GL/glew.h>
+
+#include "MeshOptimizer.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+
+
+/*
+   Levels of detail for an indexed triangle list, and the choice between them at draw time.
+
+   buildChain() simplifies with quadric error metrics (Garland and Heckbert): every vertex
+   carries the sum of the planes of its triangles, weighted by area, and the edge collapse
+   whose surviving vertex lies least far from both ends' planes goes first. Collapses are
+   half-edge, onto the other end's existing vertex, so every level indexes the original
+   vertices: the levels are index lists only, stored back to back in one buffer, with a single
+   vertex buffer under all of them. One run of collapses serves the whole chain, a snapshot
+   taken at each target triangle count, so every level is a simplification of the one before:
+
+       MeshLod::Chain chain = MeshLod::buildChain(indices, count, positions, vertexCount, stride, {20480, 5120, 1280, 320});
+       chain.print("rock");    // MESH_LOD rock: 20480 5120 1280 320 triangles, errors 0 0.0033 ...
+       for (const MeshLod::Level& level : chain.levels)
+           ... chain.indices.data() + level.firstIndex, level.indexCount ...
+
+   A level's error is, over all its collapses, the largest root mean square distance (in model
+   units) of a removed vertex's planes from the vertex it was moved onto: close to, and on
+   smooth surfaces a little under, the furthest the level strays from the original. Border
+   vertices (on an edge with one triangle) and seam vertices (sharing a position with another
+   vertex, as at a normal or texture seam) stay where they are, so outlines and attribute seams
+   keep their shape; collapses that would flip a triangle or pinch the surface are skipped. A
+   level that runs out of collapses stops short of its target.
+
+   selectLevel() picks, per object, the coarsest level whose error projects to at most
+   threshold pixels. Going coarser needs the error to be hysteresis (a fraction) below the
+   threshold and going finer needs it to exceed the threshold, so an object at a distance on
+   the edge of two levels stays where it is instead of flipping between them every frame:
+
+       float scale = MeshLod::pixelsPerUnit(fovY, viewportHeight) / distance;
+       object.level = MeshLod::selectLevel(chain.levels, object.level, scale);
+ */
+namespace MeshLod {
+
+const float THRESHOLD = 1.0f;     // pixels of projected error a level may show
+const float HYSTERESIS = 0.25f;   // how far below the threshold a coarser level must be
+
+struct Level
+{
+    GLuint firstIndex;
+    GLuint indexCount;
+    float error;                  // model units
+};
+
+
+// quadrics
+// ------------------------------------------------------------------------
+namespace detail {
+
+// the symmetric 4x4 matrix of a sum of squared plane distances, upper triangle, and the area
+// it was weighted by
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0, weight = 0;
+
+    void addPlane(double a, double b, double c, double d, double area)
+    {
+        a2 += area * a * a; ab += area * a * b; ac += area * a * c; ad += area * a * d;
+        b2 += area * b * b; bc += area * b * c; bd += area * b * d;
+        c2 += area * c * c; cd += area * c * d;
+        d2 += area * d * d;
+        weight += area;
+    }
+    void add(const Quadric& other)
+    {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+        weight += other.weight;
+    }
+    // the weighted sum of squared distances from p to the planes
+    double evaluate(const float* p) const
+    {
+        double x = p[0], y = p[1], z = p[2];
+        double result = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                      + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                      + c2 * z * z + 2 * cd * z
+                      + d2;
+        return result > 0 ? result : 0;
+    }
+};
+
+// the root mean square distance of p from the planes of q
+inline float distance(const Quadric& q, const float* p)
+{
+    return q.weight > 0 ? (float)std::sqrt(q.evaluate(p) / q.weight) : 0.0f;
+}
+
+inline void cross(const float* a, const float* b, const float* c, double normal[3])
+{
+    double u[3], v[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        u[k] = (double)b[k] - a[k];
+        v[k] = (double)c[k] - a[k];
+    }
+    normal[0] = u[1] * v[2] - u[2] * v[1];
+    normal[1] = u[2] * v[0] - u[0] * v[2];
+    normal[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+struct Collapse
+{
+    double cost;
+    uint32_t from, to;
+    uint32_t fromStamp, toStamp;
+
+    bool operator<(const Collapse& other) const { return cost > other.cost; }   // smallest first
+};
+
+} // namespace detail
+
+
+// the chain
+// ------------------------------------------------------------------------
+struct Chain
+{
+    std::vector<GLuint> indices;   // every level, back to back
+    std::vector<Level> levels;     // finest first
+    double milliseconds = 0;
+
+    void print(const std::string& name) const
+    {
+        std::cout << "MESH_LOD " << name << ":";
+        for (const Level& level : levels)
+            std::cout << " " << level.indexCount / 3;
+        std::cout << " triangles, errors";
+        for (const Level& level : levels)
+            std::cout << " " << level.error;
+        std::cout << " in " << std::fixed << std::setprecision(2) << milliseconds << " ms" << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+};
+
+// simplifies to each of targetTriangles in turn (largest first); the first level is the mesh
+// itself when the first target is at least its triangle count. An index past vertexCount is
+// reported and gives a chain with no levels
+inline Chain buildChain(const GLuint* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t stride,
+                        const std::vector<size_t>& targetTriangles)
+{
+    using namespace detail;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < indexCount; ++i)
+        if (indices[i] >= vertexCount)
+        {
+            std::cout << "ERROR::MESH_LOD::BAD_INDEX " << indices[i] << " at " << i << " of a mesh with " << vertexCount << " vertices" << std::endl;
+            return Chain();
+        }
+    auto position = [positions, stride](uint32_t vertex) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * stride);
+    };
+    size_t triangleCount = indexCount / 3;
+    std::vector<GLuint> triangles(indices, indices + triangleCount * 3);
+    std::vector<char> aliveTriangle(triangleCount, 1);
+    size_t alive = triangleCount;
+
+    // each vertex's triangles and quadric
+    std::vector<std::vector<uint32_t>> around(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const GLuint* triangle = &triangles[t * 3];
+        double normal[3];
+        cross(position(triangle[0]), position(triangle[1]), position(triangle[2]), normal);
+        double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0)
+        {
+            const float* p = position(triangle[0]);
+            double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+            for (int corner = 0; corner < 3; ++corner)
+                quadrics[triangle[corner]].addPlane(a, b, c, -(a * p[0] + b * p[1] + c * p[2]), length * 0.5);
+        }
+        for (int corner = 0; corner < 3; ++corner)
+            around[triangle[corner]].push_back((uint32_t)t);
+    }
+
+    // borders: edges with one triangle; seams: positions shared by several vertices
+    std::vector<char> locked(vertexCount, 0);
+    std::vector<uint64_t> edges;
+    edges.reserve(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            uint64_t a = triangles[t * 3 + (size_t)corner], b = triangles[t * 3 + (size_t)(corner + 1) % 3];
+            edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+        }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); )
+    {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i])
+            ++j;
+        if (j - i == 1)
+            locked[(size_t)(edges[i] >> 32)] = locked[(size_t)(edges[i] & 0xFFFFFFFFu)] = 1;
+        i = j;
+    }
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    std::vector<uint32_t> byPosition(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        byPosition[v] = v;
+    auto samePosition = [&position](uint32_t a, uint32_t b) { return std::equal(position(a), position(a) + 3, position(b)); };
+    std::sort(byPosition.begin(), byPosition.end(), [&position](uint32_t a, uint32_t b) {
+        return std::lexicographical_compare(position(a), position(a) + 3, position(b), position(b) + 3);
+    });
+    for (size_t i = 1; i < vertexCount; ++i)
+        if (samePosition(byPosition[i - 1], byPosition[i]))
+            locked[byPosition[i - 1]] = locked[byPosition[i]] = 1;
+
+    std::vector<uint32_t> stamps(vertexCount, 0);
+    std::vector<char> aliveVertex(vertexCount, 1);
+    std::priority_queue<Collapse> queue;
+    auto neighbours = [&](uint32_t vertex, std::vector<uint32_t>& result) {
+        result.clear();
+        for (uint32_t t : around[vertex])
+            if (aliveTriangle[t])
+                for (int corner = 0; corner < 3; ++corner)
+                    if (triangles[t * 3 + (size_t)corner] != vertex)
+                        result.push_back(triangles[t * 3 + (size_t)corner]);
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    };
+    auto push = [&](uint32_t from, uint32_t to) {
+        if (!locked[from])
+            queue.push({quadrics[from].evaluate(position(to)) + quadrics[to].evaluate(position(to)), from, to, stamps[from], stamps[to]});
+    };
+    for (uint64_t edge : edges)
+    {
+        uint32_t a = (uint32_t)(edge >> 32), b = (uint32_t)(edge & 0xFFFFFFFFu);
+        push(a, b);
+        push(b, a);
+    }
+
+    // moving from onto to keeps every other triangle of from facing the way it did, and
+    // from and to have no neighbours in common but the far corners of their shared triangles
+    std::vector<uint32_t> fromNeighbours, toNeighbours, common;
+    auto valid = [&](uint32_t from, uint32_t to) {
+        size_t shared = 0;
+        for (uint32_t t : around[from])
+        {
+            if (!aliveTriangle[t])
+                continue;
+            const GLuint* triangle = &triangles[t * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+            {
+                ++shared;
+                continue;
+            }
+            const float* corners[3];
+            for (int corner = 0; corner < 3; ++corner)
+                corners[corner] = position(triangle[corner]);
+            double before[3], after[3];
+            cross(corners[0], corners[1], corners[2], before);
+            for (int corner = 0; corner < 3; ++corner)
+                if (triangle[corner] == from)
+                    corners[corner] = position(to);
+            cross(corners[0], corners[1], corners[2], after);
+            if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0)
+                return false;
+        }
+        neighbours(from, fromNeighbours);
+        neighbours(to, toNeighbours);
+        common.clear();
+        std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(), toNeighbours.begin(), toNeighbours.end(), std::back_inserter(common));
+        return shared > 0 && common.size() <= shared;
+    };
+
+    Chain chain;
+    float error = 0.0f;
+    std::vector<size_t> targets(targetTriangles);
+    std::sort(targets.begin(), targets.end(), [](size_t a, size_t b) { return a > b; });
+    for (size_t target : targets)
+    {
+        while (alive > target && !queue.empty())
+        {
+            Collapse collapse = queue.top();
+            queue.pop();
+            uint32_t from = collapse.from, to = collapse.to;
+            if (!aliveVertex[from] || !aliveVertex[to] || stamps[from] != collapse.fromStamp || stamps[to] != collapse.toStamp)
+                continue;
+            if (!valid(from, to))
+                continue;
+
+            for (uint32_t t : around[from])
+            {
+                if (!aliveTriangle[t])
+                    continue;
+                GLuint* triangle = &triangles[t * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                {
+                    aliveTriangle[t] = 0;
+                    --alive;
+                    continue;
+                }
+                for (int corner = 0; corner < 3; ++corner)
+                    if (triangle[corner] == from)
+                        triangle[corner] = to;
+                around[to].push_back(t);
+            }
+            around[from].clear();
+            aliveVertex[from] = 0;
+            error = std::max(error, distance(quadrics[from], position(to)));
+            quadrics[to].add(quadrics[from]);
+            ++stamps[to];
+
+            neighbours(to, toNeighbours);
+            for (uint32_t neighbour : toNeighbours)
+            {
+                push(to, neighbour);
+                push(neighbour, to);
+            }
+        }
+
+        Level level = { (GLuint)chain.indices.size(), 0, error };
+        for (size_t t = 0; t < triangleCount; ++t)
+            if (aliveTriangle[t])
+                chain.indices.insert(chain.indices.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+        level.indexCount = (GLuint)(chain.indices.size() - level.firstIndex);
+        GLuint* levelIndices = chain.indices.data() + level.firstIndex;
+        MeshOptimizer::optimizeVertexCache(levelIndices, levelIndices, level.indexCount, vertexCount);
+        chain.levels.push_back(level);
+    }
+    chain.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return chain;
+}
+
+
+// selection
+// ------------------------------------------------------------------------
+
+// how many pixels one model unit at distance 1 covers, for a vertical field of view in radians
+inline float pixelsPerUnit(float fovY, float viewportHeight)
+{
+    return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+// the level to draw for an object drawn at current, where one model unit covers scale pixels
+// (pixelsPerUnit / distance, times the object's scale); 0 when there are no levels
+inline int selectLevel(const std::vector<Level>& levels, int current, float scale, float threshold = THRESHOLD, float hysteresis = HYSTERESIS)
+{
+    if (levels.empty())
+        return 0;
+    int last = (int)levels.size() - 1;
+    current = std::min(std::max(current, 0), last);
+    int fits = 0, comfortable = 0;
+    for (int level = 0; level <= last; ++level)
+    {
+        float pixels = levels[(size_t)level].error * scale;
+        if (pixels <= threshold)
+            fits = level;
+        if (pixels <= threshold * (1.0f - hysteresis))
+            comfortable = level;
+    }
+    if (comfortable > current)
+        return comfortable;
+    if (levels[(size_t)current].error * scale > threshold)
+        return fits;
+    return current;
+}
+
+} // namespace MeshLod
+
+#endif /* MeshLod_h */
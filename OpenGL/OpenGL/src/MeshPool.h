@@ -0,0 +1,276 @@
+//
+//  MeshPool.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/13/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef MESH_POOL_H
+#define MESH_POOL_H
+
+#include <GL/glew.h>
+
+#include "InstancedMesh.h"
+#include "StreamBuffer.h"
+
+#include <iostream>
+#include <vector>
+#include <initializer_list>
+#include <cstring>
+#include <cstdint>
+
+
+// the record glMultiDrawElementsIndirect reads for each draw
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must be tightly packed");
+
+
+/*
+   Many meshes in one vertex buffer and one index buffer, all sharing a vertex layout and a
+   vertex array, so a whole list of them draws without any bind in between. Each frame the
+   visible meshes are listed with draw(), and submit() issues the list:
+
+       MeshPool pool({{0, 2}}, 1, 10000, 60000, 50000);   // position; instance id at location 1
+       int quad = pool.add(vertices, 4, indices, 6);
+       ...
+       pool.clear();
+       GLuint slot = pool.draw(quad);                      // per-instance data lives at slot
+       ...
+       pool.submit();
+       pool.endFrame();                                    // after the frame's last submit
+
+   With GL 4.3 or ARB_multi_draw_indirect the list is written as DrawElementsIndirectCommands
+   into a GL_DRAW_INDIRECT_BUFFER ring and drawn by a single glMultiDrawElementsIndirect.
+   Elsewhere (macOS stops at 4.1) submit() walks the same list with one
+   glDrawElementsInstancedBaseVertex per entry.
+
+   Shaders find their per-draw data through an unsigned instance id attribute that the pool
+   feeds at the given location: every draw gets a run of slots (one per instance) handed out
+   in order, and the id is the slot. It comes from baseInstance, so it works where gl_DrawID
+   and gl_BaseInstance (ARB_shader_draw_parameters) do not; index a texture buffer or a storage
+   buffer with it:
+
+       layout (location = 1) in uint aInstance;
+       uniform samplerBuffer uPlacements;
+       ... texelFetch(uPlacements, int(aInstance)) ...
+ */
+class MeshPool
+{
+public:
+    struct Mesh
+    {
+        GLuint indexCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+    };
+
+    MeshPool(std::initializer_list<InstancedMesh::Attribute> layout, GLuint instanceLocation, size_t maxVertices, size_t maxIndices, size_t maxInstances, bool allowIndirect = true)
+        : instanceLocation(instanceLocation), maxVertices(maxVertices), maxIndices(maxIndices), maxInstances(maxInstances),
+          commandRing(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(maxInstances * sizeof(DrawElementsIndirectCommand)))
+    {
+        multiDrawIndirect = allowIndirect && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+        commands.reserve(maxInstances);
+
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glGenBuffers(1, &instanceIds);
+        glBindVertexArray(vao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        for (const InstancedMesh::Attribute& attribute : layout)
+            stride += attribute.components * (GLsizei)sizeof(float);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(maxVertices * (size_t)stride), nullptr, GL_STATIC_DRAW);
+        size_t offset = 0;
+        for (const InstancedMesh::Attribute& attribute : layout)
+        {
+            glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+            glEnableVertexAttribArray(attribute.location);
+            offset += (size_t)attribute.components * sizeof(float);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(maxIndices * sizeof(GLuint)), nullptr, GL_STATIC_DRAW);
+
+        // slot i holds i, so the attribute read at instance baseInstance + j is that slot
+        std::vector<GLuint> ids(maxInstances);
+        for (size_t i = 0; i < maxInstances; ++i)
+            ids[i] = (GLuint)i;
+        glBindBuffer(GL_ARRAY_BUFFER, instanceIds);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(maxInstances * sizeof(GLuint)), ids.data(), GL_STATIC_DRAW);
+        glVertexAttribIPointer(instanceLocation, 1, GL_UNSIGNED_INT, 0, nullptr);
+        glEnableVertexAttribArray(instanceLocation);
+        glVertexAttribDivisor(instanceLocation, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    ~MeshPool()
+    {
+        glDeleteBuffers(1, &instanceIds);
+        glDeleteBuffers(1, &ebo);
+        glDeleteBuffers(1, &vbo);
+        glDeleteVertexArrays(1, &vao);
+    }
+    MeshPool(const MeshPool&) = delete;
+    MeshPool& operator=(const MeshPool&) = delete;
+
+    // copies a mesh into the shared buffers and returns its number, or -1 if it does not fit
+    // ------------------------------------------------------------------------
+    int add(const float* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount)
+    {
+        if (usedVertices + vertexCount > maxVertices || usedIndices + indexCount > maxIndices)
+        {
+            std::cout << "ERROR::MESH_POOL::FULL no room for " << vertexCount << " vertices and " << indexCount << " indices" << std::endl;
+            return -1;
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(usedVertices * (size_t)stride), (GLsizeiptr)(vertexCount * (size_t)stride), vertices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)(usedIndices * sizeof(GLuint)), (GLsizeiptr)(indexCount * sizeof(GLuint)), indices);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        meshes.push_back({(GLuint)indexCount, (GLuint)usedIndices, (GLint)usedVertices});
+        usedVertices += vertexCount;
+        usedIndices += indexCount;
+        return (int)meshes.size() - 1;
+    }
+
+    // another index list over the vertices of an earlier mesh, e.g. a level of detail of it;
+    // returns the new mesh's number, or -1 if the indices do not fit
+    int addIndices(int id, const GLuint* indices, size_t indexCount)
+    {
+        if (id < 0 || (size_t)id >= meshes.size())
+        {
+            std::cout << "ERROR::MESH_POOL::NO_MESH " << id << " of " << meshes.size() << std::endl;
+            return -1;
+        }
+        if (usedIndices + indexCount > maxIndices)
+        {
+            std::cout << "ERROR::MESH_POOL::FULL no room for " << indexCount << " indices" << std::endl;
+            return -1;
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)(usedIndices * sizeof(GLuint)), (GLsizeiptr)(indexCount * sizeof(GLuint)), indices);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        meshes.push_back({(GLuint)indexCount, (GLuint)usedIndices, meshes[(size_t)id].baseVertex});
+        usedIndices += indexCount;
+        return (int)meshes.size() - 1;
+    }
+
+    const Mesh& mesh(int id) const { return meshes[(size_t)id]; }
+    size_t meshCount() const { return meshes.size(); }
+
+    // starts a new draw list
+    void clear()
+    {
+        commands.clear();
+        usedInstances = 0;
+    }
+
+    // lists instances copies of a mesh and returns the first of their instance slots, or
+    // INVALID_SLOT when the pool has run out of slots or has no such mesh
+    // ------------------------------------------------------------------------
+    GLuint draw(int id, GLuint instances = 1)
+    {
+        if (id < 0 || (size_t)id >= meshes.size())
+        {
+            std::cout << "ERROR::MESH_POOL::NO_MESH " << id << " of " << meshes.size() << std::endl;
+            return INVALID_SLOT;
+        }
+        if (usedInstances + instances > maxInstances)
+            return INVALID_SLOT;
+        const Mesh& target = meshes[(size_t)id];
+        GLuint slot = (GLuint)usedInstances;
+        commands.push_back({target.indexCount, instances, target.firstIndex, target.baseVertex, slot});
+        usedInstances += instances;
+        return slot;
+    }
+
+    size_t drawCount() const { return commands.size(); }
+    bool indirect() const { return multiDrawIndirect; }
+    GLuint vertexArray() const { return vao; }
+
+    // draws everything listed since clear()
+    // ------------------------------------------------------------------------
+    void submit(GLenum mode = GL_TRIANGLES)
+    {
+        submit(commands.data(), commands.size(), mode);
+    }
+
+    // draws a list built elsewhere; its baseInstances are slots, as draw() hands them out
+    void submit(const DrawElementsIndirectCommand* list, size_t count, GLenum mode = GL_TRIANGLES)
+    {
+        if (count == 0)
+            return;
+        glBindVertexArray(vao);
+        // a list too long for the command ring goes through the per-draw path
+        GLsizeiptr size = (GLsizeiptr)(count * sizeof(DrawElementsIndirectCommand));
+        void* memory = multiDrawIndirect ? commandRing.reserve(size, sizeof(GLuint)) : nullptr;
+        if (memory != nullptr)
+        {
+            std::memcpy(memory, list, (size_t)size);
+            GLintptr offset = commandRing.commit(size);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandRing.buffer());
+            glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (const void*)(uintptr_t)offset, (GLsizei)count, 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        else
+        {
+            // without baseInstance the instance id attribute is moved to each draw's first slot
+            glBindBuffer(GL_ARRAY_BUFFER, instanceIds);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const DrawElementsIndirectCommand& command = list[i];
+                glVertexAttribIPointer(instanceLocation, 1, GL_UNSIGNED_INT, 0, (const void*)(uintptr_t)(command.baseInstance * sizeof(GLuint)));
+                glDrawElementsInstancedBaseVertex(mode, (GLsizei)command.count, GL_UNSIGNED_INT, (const void*)(uintptr_t)(command.firstIndex * sizeof(GLuint)), (GLsizei)command.instanceCount, command.baseVertex);
+            }
+            glVertexAttribIPointer(instanceLocation, 1, GL_UNSIGNED_INT, 0, nullptr);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        glBindVertexArray(0);
+    }
+
+    // draws drawCount commands that are already in a buffer, e.g. written there by a compute
+    // shader, so they never pass through the CPU; needs multi-draw indirect
+    void submitIndirect(GLuint buffer, GLsizei drawCount, GLenum mode = GL_TRIANGLES)
+    {
+        if (!multiDrawIndirect || drawCount == 0)
+            return;
+        glBindVertexArray(vao);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+        glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, nullptr, drawCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void endFrame() { commandRing.endFrame(); }
+
+    static const GLuint INVALID_SLOT = 0xFFFFFFFFu;
+
+private:
+    GLuint instanceLocation;
+    size_t maxVertices, maxIndices, maxInstances;
+    StreamBuffer commandRing;       // filled through GL_COPY_WRITE_BUFFER, which exists before 4.0
+    bool multiDrawIndirect = false;
+
+    GLuint vao = 0, vbo = 0, ebo = 0, instanceIds = 0;
+    GLsizei stride = 0;
+    size_t usedVertices = 0, usedIndices = 0, usedInstances = 0;
+    std::vector<Mesh> meshes;
+    std::vector<DrawElementsIndirectCommand> commands;
+};
+
+#endif /* MeshPool_h */
@@ -0,0 +1,374 @@
+//
+//  OcclusionCuller.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <GL/glew.h>
+
+#include "FrustumCuller.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+
+/*
+   Occlusion culling with hardware queries. Every object is a box. After the frame's draws
+   have filled the depth buffer, test() draws each box, invisibly, inside an occlusion query
+   (GL_ANY_SAMPLES_PASSED_CONSERVATIVE, or GL_ANY_SAMPLES_PASSED before GL 4.3); the next frame
+   draws the object only if its box passed:
+
+       occlusion.beginFrame(viewProjection, width, height);
+       drawOccluders();
+       for (object : objects)
+           if (occlusion.begin(object.id))      // false: known to be hidden, skip the draw
+           {
+               drawObject(object);
+               occlusion.end(object.id);
+           }
+       occlusion.test(ids, count);              // the objects worth testing, e.g. those in the frustum
+
+   Results are a frame old, so nothing waits on a query the GPU has just been given. Where the
+   previous frame's result is already available, begin() reads it and a hidden object costs
+   no draw call at all; otherwise the draw goes inside glBeginConditionalRender on that query
+   and the GPU drops it. The query was issued a whole frame earlier, so GL_QUERY_WAIT costs
+   the GPU nothing in practice and makes the skip exact. An object appearing from behind an
+   occluder shows up one frame late.
+
+   Boxes that cross the near plane cannot be tested (their front faces are clipped away) and
+   always draw. Queries come from a pool that grows in batches and takes every query back once
+   it has been used, so a steady scene allocates none after the first frames.
+
+   stats() counts the draws skipped, by the CPU and by the GPU (the latter known once the
+   result comes back), and estimates the fragments saved as the screen area of each skipped
+   object's box: an upper bound, as the object covers less than its box.
+ */
+class OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        unsigned long tested;          // boxes drawn inside a query
+        unsigned long skippedOnCpu;    // draws not issued
+        unsigned long skippedOnGpu;    // conditional draws the GPU dropped
+        double fragmentsSaved;
+    };
+
+    OcclusionCuller()
+    {
+        queryTarget = GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+        createProgram();
+        createBox();
+    }
+    ~OcclusionCuller()
+    {
+        glDeleteQueries((GLsizei)queries.size(), queries.data());
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteProgram(program);
+    }
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    uint32_t add(const float minimum[3], const float maximum[3])
+    {
+        Object object;
+        std::copy(minimum, minimum + 3, object.minimum);
+        std::copy(maximum, maximum + 3, object.maximum);
+        objects.push_back(object);
+        return (uint32_t)(objects.size() - 1);
+    }
+
+    void setBounds(uint32_t id, const float minimum[3], const float maximum[3])
+    {
+        std::copy(minimum, minimum + 3, objects[id].minimum);
+        std::copy(maximum, maximum + 3, objects[id].maximum);
+    }
+
+    // starts a frame seen through viewProjection on a width x height viewport, and collects
+    // whatever conditional draws of earlier frames have an answer by now
+    // ------------------------------------------------------------------------
+    void beginFrame(const glm::mat4& viewProjection, int width, int height)
+    {
+        matrix = viewProjection;
+        frustum = Frustum::fromMatrix(viewProjection);
+        viewport[0] = (float)width;
+        viewport[1] = (float)height;
+        frameStats = Stats();
+        ++frame;
+
+        size_t kept = 0;
+        for (const Pending& pending : conditional)
+        {
+            if (!available(pending.query))
+            {
+                conditional[kept++] = pending;
+                continue;
+            }
+            if (!passed(pending.query))
+            {
+                ++frameStats.skippedOnGpu;
+                frameStats.fragmentsSaved += pending.area;
+            }
+            release(pending.query);
+        }
+        conditional.resize(kept);
+    }
+
+    // whether to draw the object; when it returns true, call end() after the draw
+    bool begin(uint32_t id)
+    {
+        Object& object = objects[id];
+        object.conditional = false;
+        GLuint query = object.query;
+        if (query == 0)
+            return true;
+        object.query = 0;
+
+        // a result older than last frame's says nothing about where the camera is now
+        if (object.queryFrame + 1 != frame || crossesNearPlane(object))
+        {
+            release(query);
+            return true;
+        }
+        if (available(query))
+        {
+            bool visible = passed(query);
+            release(query);
+            if (!visible)
+            {
+                ++frameStats.skippedOnCpu;
+                frameStats.fragmentsSaved += screenArea(object);
+            }
+            return visible;
+        }
+        glBeginConditionalRender(query, GL_QUERY_WAIT);
+        object.conditional = true;
+        conditional.push_back({query, screenArea(object)});
+        return true;
+    }
+
+    void end(uint32_t id)
+    {
+        if (objects[id].conditional)
+            glEndConditionalRender();
+        objects[id].conditional = false;
+    }
+
+    // queries the boxes of the given objects against the depth buffer as it is now; their
+    // results decide next frame's draws. Leaves color and depth writes on and no program bound.
+    // ------------------------------------------------------------------------
+    void test(const uint32_t* ids, size_t count)
+    {
+        GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_CULL_FACE);
+        glUseProgram(program);
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(matrix));
+        glBindVertexArray(vao);
+        for (size_t i = 0; i < count; ++i)
+        {
+            Object& object = objects[ids[i]];
+            if (object.query != 0)
+                release(object.query);      // never consumed: the object was not drawn
+            object.query = 0;
+            if (crossesNearPlane(object))
+                continue;
+            object.query = acquire();
+            object.queryFrame = frame;
+            glUniform3fv(minimumLocation, 1, object.minimum);
+            glUniform3fv(maximumLocation, 1, object.maximum);
+            glBeginQuery(queryTarget, object.query);
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, nullptr);
+            glEndQuery(queryTarget);
+            ++frameStats.tested;
+        }
+        glBindVertexArray(0);
+        glUseProgram(0);
+        if (cullFace)
+            glEnable(GL_CULL_FACE);
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    // this frame's counts so far; GPU skips arrive a frame or more after the draw
+    const Stats& stats() const { return frameStats; }
+    size_t size() const { return objects.size(); }
+    size_t pooledQueries() const { return queries.size(); }
+    bool conservative() const { return queryTarget == GL_ANY_SAMPLES_PASSED_CONSERVATIVE; }
+
+private:
+    static const size_t QUERY_BATCH = 64;
+
+    struct Object
+    {
+        float minimum[3];
+        float maximum[3];
+        GLuint query = 0;                   // last test(), not yet consumed by begin()
+        unsigned long queryFrame = 0;
+        bool conditional = false;
+    };
+    struct Pending
+    {
+        GLuint query;
+        double area;
+    };
+
+    std::vector<Object> objects;
+    std::vector<GLuint> queries;            // every query the pool made
+    std::vector<GLuint> freeQueries;
+    std::vector<Pending> conditional;       // conditional draws whose result is not read yet
+    GLenum queryTarget;
+    unsigned long frame = 0;
+    glm::mat4 matrix;
+    Frustum frustum;
+    float viewport[2] = {0.0f, 0.0f};
+    Stats frameStats = Stats();
+
+    GLuint program = 0, vao = 0, vbo = 0, ebo = 0;
+    GLint viewProjectionLocation = -1, minimumLocation = -1, maximumLocation = -1;
+
+    GLuint acquire()
+    {
+        if (freeQueries.empty())
+        {
+            size_t first = queries.size();
+            queries.resize(first + QUERY_BATCH);
+            glGenQueries((GLsizei)QUERY_BATCH, queries.data() + first);
+            freeQueries.assign(queries.begin() + (std::ptrdiff_t)first, queries.end());
+        }
+        GLuint query = freeQueries.back();
+        freeQueries.pop_back();
+        return query;
+    }
+
+    void release(GLuint query) { freeQueries.push_back(query); }
+
+    static bool available(GLuint query)
+    {
+        GLuint ready = GL_FALSE;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &ready);
+        return ready == GL_TRUE;
+    }
+
+    static bool passed(GLuint query)
+    {
+        GLuint result = GL_TRUE;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &result);
+        return result != GL_FALSE;
+    }
+
+    // the box's nearest corner is behind the near plane (planes[4])
+    bool crossesNearPlane(const Object& object) const
+    {
+        const float* plane = frustum.planes[4];
+        float distance = plane[3];
+        for (int k = 0; k < 3; ++k)
+            distance += plane[k] * (plane[k] >= 0.0f ? object.minimum[k] : object.maximum[k]);
+        return distance < 0.0f;
+    }
+
+    // pixels of the rectangle around the box's projection, clipped to the viewport
+    double screenArea(const Object& object) const
+    {
+        float low[2] = {1.0f, 1.0f}, high[2] = {-1.0f, -1.0f};
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec4 point = matrix * glm::vec4(corner & 1 ? object.maximum[0] : object.minimum[0],
+                                                 corner & 2 ? object.maximum[1] : object.minimum[1],
+                                                 corner & 4 ? object.maximum[2] : object.minimum[2], 1.0f);
+            for (int k = 0; k < 2; ++k)
+            {
+                float ndc = point[k] / point.w;
+                low[k] = std::min(low[k], ndc);
+                high[k] = std::max(high[k], ndc);
+            }
+        }
+        double area = 1.0;
+        for (int k = 0; k < 2; ++k)
+            area *= std::max(0.0f, std::min(high[k], 1.0f) - std::max(low[k], -1.0f)) * 0.5f * viewport[k];
+        return area;
+    }
+
+    void createBox()
+    {
+        const float corners[] = {
+            0.0f, 0.0f, 0.0f,   1.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 1.0f,   1.0f, 0.0f, 1.0f,   0.0f, 1.0f, 1.0f,   1.0f, 1.0f, 1.0f
+        };
+        const GLubyte faces[] = {
+            0, 2, 1,  1, 2, 3,    4, 5, 6,  5, 7, 6,    // -z, +z
+            0, 1, 4,  1, 5, 4,    2, 6, 3,  3, 6, 7,    // -y, +y
+            0, 4, 2,  2, 4, 6,    1, 3, 5,  3, 7, 5     // -x, +x
+        };
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(faces), faces, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void createProgram()
+    {
+        const char* vertexSource = "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "uniform mat4 uViewProjection;\n"
+        "uniform vec3 uMinimum;\n"
+        "uniform vec3 uMaximum;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = uViewProjection * vec4(mix(uMinimum, uMaximum, aPos), 1.0);\n"
+        "}\0";
+        const char* fragmentSource = "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "void main()\n"
+        "{\n"
+        "   FragColor = vec4(1.0);\n"
+        "}\n\0";
+
+        int success;
+        char infoLog[512];
+        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertexShader, 1, &vertexSource, NULL);
+        glCompileShader(vertexShader);
+        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+        glCompileShader(fragmentShader);
+        program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::OCCLUSION_CULLER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        viewProjectionLocation = glGetUniformLocation(program, "uViewProjection");
+        minimumLocation = glGetUniformLocation(program, "uMinimum");
+        maximumLocation = glGetUniformLocation(program, "uMaximum");
+    }
+};
+
+#endif /* OcclusionCuller_h */
@@ -0,0 +1,455 @@
+//
+//  PackedMesh.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef PACKED_MESH_H
+#define PACKED_MESH_H
+
+#include <GL/glew.h>
+
+#include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "VertexEncoder.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+
+namespace packed_mesh {
+
+const uint32_t MAGIC = 0x48534d50;     // "PMSH"
+const uint32_t VERSION = 2;            // 2 added 8-bit indices; version 1 files still load
+const uint64_t ALIGNMENT = 64;         // of the vertex and index blobs within the file
+const uint32_t MAX_ATTRIBUTES = 16;
+
+// Everything is little-endian. The file is
+//     Header | Attribute[attributeCount] | Submesh[submeshCount] | vertices | indices
+// with both blobs starting on an ALIGNMENT boundary.
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+    uint32_t vertexCount;
+    uint32_t vertexStride;
+    uint32_t indexCount;
+    uint32_t indexType;                // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t attributeCount;
+    uint32_t submeshCount;
+    uint64_t attributeOffset;
+    uint64_t submeshOffset;
+    uint64_t vertexOffset;
+    uint64_t vertexBytes;
+    uint64_t indexOffset;
+    uint64_t indexBytes;
+    float minimum[3];                  // bounds of every submesh
+    float maximum[3];
+};
+static_assert(sizeof(Header) == 112, "packed_mesh::Header must be tightly packed");
+
+// one vertex attribute, as glVertexAttribPointer (or glVertexAttribIPointer) takes it
+struct Attribute
+{
+    uint32_t location;
+    uint32_t type;
+    uint32_t components;
+    uint16_t offset;
+    uint8_t mode;                      // AttributeMode
+    uint8_t reserved;
+};
+static_assert(sizeof(Attribute) == 16, "packed_mesh::Attribute must be tightly packed");
+
+// a range of the index blob; its indices count from baseVertex
+struct Submesh
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t baseVertex;
+    uint32_t vertexCount;
+    float minimum[3];
+    float maximum[3];
+    char name[40];
+};
+static_assert(sizeof(Submesh) == 80, "packed_mesh::Submesh must be tightly packed");
+
+// the compressed vertex PackedMesh::write() produces on request: 16 bytes instead of 32
+struct CompactVertex
+{
+    Half position[4];
+    Packed2101010 normal;
+    Half texCoord[2];
+};
+using CompactVertexLayout = VertexLayout<CompactVertex,
+    VERTEX_ATTRIBUTE(CompactVertex, position, 0),
+    VERTEX_ATTRIBUTE_NORMALIZED(CompactVertex, normal, 1),
+    VERTEX_ATTRIBUTE(CompactVertex, texCoord, 2)>;
+
+} // namespace packed_mesh
+
+
+/*
+   A binary mesh container that loads without parsing. An offline step packs any number of
+   meshes (from MeshLoader) into one file as submeshes sharing a vertex and an index blob:
+
+       PackedMesh::write("scene.mesh", {"floor", "crate"}, {floorData, crateData});
+
+   and at runtime the file is memory-mapped and its blobs handed straight to glBufferStorage
+   (glBufferData before GL 4.4), so the bytes go from the page cache to the driver without
+   any copy or conversion of ours:
+
+       PackedMesh scene;
+       if (scene.load("scene.mesh"))
+       {
+           glBindVertexArray(scene.vertexArray());
+           scene.draw();                          // every submesh, one glMultiDrawElementsBaseVertex
+           int crate = scene.find("crate");
+           if (crate >= 0)
+               scene.drawSubmesh(crate);
+       }
+
+   The vertex layout travels in the file as a list of attributes, so a file written with
+   compress = true (half positions and texcoords, 10:10:10:2 normals, 16 bytes a vertex) loads
+   the same way. Indices are as narrow as the largest submesh allows: 8-bit up to 256 vertices,
+   16-bit up to 65536 (see MeshOptimizer::indexType), 32-bit beyond. Headers
+   and ranges are checked on load; a file from a newer VERSION is refused.
+ */
+class PackedMesh
+{
+public:
+    PackedMesh() {}
+    ~PackedMesh() { release(); }
+    PackedMesh(const PackedMesh&) = delete;
+    PackedMesh& operator=(const PackedMesh&) = delete;
+
+    // returns false (after printing why) if the file cannot be read or is not a valid mesh
+    // ------------------------------------------------------------------------
+    bool load(const std::string& path)
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        release();
+        mesh_loader::MappedFile file(path);
+        if (!file.valid())
+        {
+            std::cout << "ERROR::PACKED_MESH::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+            return false;
+        }
+        if (!validate(path, file))
+            return false;
+        const char* bytes = file.begin();
+        attributes.resize(head.attributeCount);
+        submeshes.resize(head.submeshCount);
+        std::memcpy(attributes.data(), bytes + head.attributeOffset, attributes.size() * sizeof(packed_mesh::Attribute));
+        std::memcpy(submeshes.data(), bytes + head.submeshOffset, submeshes.size() * sizeof(packed_mesh::Submesh));
+        for (const packed_mesh::Submesh& submesh : submeshes)
+            if (!checkSubmesh(path, submesh))
+            {
+                submeshes.clear();
+                return false;
+            }
+        mapMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        Clock::time_point upload = Clock::now();
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        store(GL_ARRAY_BUFFER, head.vertexBytes, bytes + head.vertexOffset);
+        for (const packed_mesh::Attribute& attribute : attributes)
+        {
+            const void* offset = (const void*)(uintptr_t)attribute.offset;
+            if (attribute.mode == (uint8_t)AttributeMode::Integer)
+                glVertexAttribIPointer(attribute.location, (GLint)attribute.components, attribute.type, (GLsizei)head.vertexStride, offset);
+            else
+                glVertexAttribPointer(attribute.location, (GLint)attribute.components, attribute.type,
+                                      attribute.mode == (uint8_t)AttributeMode::Normalized ? GL_TRUE : GL_FALSE, (GLsizei)head.vertexStride, offset);
+            glEnableVertexAttribArray(attribute.location);
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        store(GL_ELEMENT_ARRAY_BUFFER, head.indexBytes, bytes + head.indexOffset);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // draw() hands every submesh to one glMultiDrawElementsBaseVertex
+        size_t indexSize = MeshOptimizer::indexSize(head.indexType);
+        for (const packed_mesh::Submesh& submesh : submeshes)
+        {
+            counts.push_back((GLsizei)submesh.indexCount);
+            offsets.push_back((const void*)(uintptr_t)(submesh.firstIndex * indexSize));
+            baseVertices.push_back(submesh.baseVertex);
+        }
+        uploadMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - upload).count();
+        totalMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return true;
+    }
+
+    // deletes the GL objects. The destructor does the same, so this is only needed when the
+    // context goes away before the mesh does
+    void release()
+    {
+        if (vao != 0)
+        {
+            glDeleteBuffers(1, &ebo);
+            glDeleteBuffers(1, &vbo);
+            glDeleteVertexArrays(1, &vao);
+            vao = vbo = ebo = 0;
+        }
+        attributes.clear();
+        submeshes.clear();
+        counts.clear();
+        offsets.clear();
+        baseVertices.clear();
+    }
+
+    // both draw from the bound vertex array; bind vertexArray() first (directly or through a
+    // StateCache)
+    // ------------------------------------------------------------------------
+    void draw(GLenum mode = GL_TRIANGLES) const
+    {
+        if (!counts.empty())
+            glMultiDrawElementsBaseVertex(mode, counts.data(), head.indexType, offsets.data(), (GLsizei)counts.size(), baseVertices.data());
+    }
+    void drawSubmesh(size_t index, GLenum mode = GL_TRIANGLES) const
+    {
+        if (index >= submeshes.size())
+        {
+            std::cout << "ERROR::PACKED_MESH::NO_SUBMESH " << index << " of " << submeshes.size() << std::endl;
+            return;
+        }
+        glDrawElementsBaseVertex(mode, counts[index], head.indexType, offsets[index], baseVertices[index]);
+    }
+
+    GLuint vertexArray() const { return vao; }
+    const packed_mesh::Header& header() const { return head; }
+    size_t submeshCount() const { return submeshes.size(); }
+    const packed_mesh::Submesh& submesh(size_t index) const { return submeshes[index]; }
+
+    // the index of the submesh with this name, or -1
+    int find(const std::string& name) const
+    {
+        for (size_t i = 0; i < submeshes.size(); ++i)
+            if (name == submeshes[i].name)
+                return (int)i;
+        return -1;
+    }
+
+    void printStats() const
+    {
+        const double megabyte = 1024.0 * 1024.0;
+        std::cout << std::fixed << std::setprecision(1)
+                  << "PACKED_MESH " << head.fileSize / megabyte << " MB: " << submeshes.size() << " submeshes, " << head.vertexCount
+                  << " vertices x " << head.vertexStride << " bytes, " << head.indexCount << " " << MeshOptimizer::indexSize(head.indexType) * 8
+                  << "-bit indices in " << std::setprecision(2) << totalMilliseconds << " ms (map: " << mapMilliseconds << " ms "
+                  << (bufferStorage() ? "glBufferStorage" : "glBufferData") << ": " << uploadMilliseconds << " ms)"
+                  << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+
+    // packs meshes into a file as submeshes named after names; returns false (after printing
+    // why) if it cannot be written. Positions, normals and texcoords are kept as floats, or
+    // with compress as halves and 10:10:10:2.
+    // ------------------------------------------------------------------------
+    static bool write(const std::string& path, const std::vector<std::string>& names, const std::vector<MeshData>& meshes, bool compress = false)
+    {
+        if (compress)
+            return writeAs<packed_mesh::CompactVertex, packed_mesh::CompactVertexLayout>(path, names, meshes, [](const MeshVertex& in, packed_mesh::CompactVertex& out) {
+                for (int k = 0; k < 3; ++k)
+                    out.position[k].bits = VertexEncoder::toHalf(in.position[k]);
+                out.position[3].bits = VertexEncoder::toHalf(1.0f);
+                out.normal.bits = VertexEncoder::toSnorm2101010(in.normal);
+                out.texCoord[0].bits = VertexEncoder::toHalf(in.texCoord[0]);
+                out.texCoord[1].bits = VertexEncoder::toHalf(in.texCoord[1]);
+            });
+        return writeAs<MeshVertex, MeshVertexLayout>(path, names, meshes, [](const MeshVertex& in, MeshVertex& out) { out = in; });
+    }
+
+private:
+    packed_mesh::Header head = {};
+    std::vector<packed_mesh::Attribute> attributes;
+    std::vector<packed_mesh::Submesh> submeshes;
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    double mapMilliseconds = 0, uploadMilliseconds = 0, totalMilliseconds = 0;
+
+    static bool bufferStorage() { return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage; }
+
+    // immutable storage where there is any, filled straight from the mapping
+    static void store(GLenum target, uint64_t bytes, const void* data)
+    {
+        if (bufferStorage())
+            glBufferStorage(target, (GLsizeiptr)bytes, data, 0);
+        else
+            glBufferData(target, (GLsizeiptr)bytes, data, GL_STATIC_DRAW);
+    }
+
+    static bool fits(uint64_t offset, uint64_t bytes, uint64_t size)
+    {
+        return offset <= size && bytes <= size - offset;
+    }
+
+    bool validate(const std::string& path, const mesh_loader::MappedFile& file)
+    {
+        const char* problem = nullptr;
+        if (file.size() < sizeof(packed_mesh::Header))
+            problem = "too short";
+        else
+        {
+            std::memcpy(&head, file.begin(), sizeof(head));
+            uint64_t size = file.size();
+            size_t indexSize = MeshOptimizer::indexSize(head.indexType);
+            if (head.magic != packed_mesh::MAGIC)
+                problem = "not a packed mesh";
+            else if (head.version == 0 || head.version > packed_mesh::VERSION)
+                problem = "unsupported version";
+            else if (head.fileSize != size)
+                problem = "truncated";
+            else if (head.attributeCount == 0 || head.attributeCount > packed_mesh::MAX_ATTRIBUTES ||
+                     !fits(head.attributeOffset, head.attributeCount * sizeof(packed_mesh::Attribute), size) ||
+                     !fits(head.submeshOffset, head.submeshCount * (uint64_t)sizeof(packed_mesh::Submesh), size))
+                problem = "bad attribute or submesh table";
+            else if (head.vertexOffset % packed_mesh::ALIGNMENT != 0 || head.indexOffset % packed_mesh::ALIGNMENT != 0 ||
+                     head.vertexBytes != (uint64_t)head.vertexCount * head.vertexStride || !fits(head.vertexOffset, head.vertexBytes, size) ||
+                     (head.indexType != GL_UNSIGNED_BYTE && head.indexType != GL_UNSIGNED_SHORT && head.indexType != GL_UNSIGNED_INT) ||
+                     head.indexBytes != (uint64_t)head.indexCount * indexSize || !fits(head.indexOffset, head.indexBytes, size))
+                problem = "bad vertex or index blob";
+            else
+                for (uint32_t i = 0; i < head.attributeCount; ++i)
+                {
+                    packed_mesh::Attribute attribute;
+                    std::memcpy(&attribute, file.begin() + head.attributeOffset + i * sizeof(attribute), sizeof(attribute));
+                    if (attribute.offset >= head.vertexStride || attribute.components < 1 || attribute.components > 4 || attribute.mode > 2)
+                        problem = "bad attribute";
+                }
+        }
+        if (problem != nullptr)
+        {
+            std::cout << "ERROR::PACKED_MESH::BAD_FILE " << path << ": " << problem << std::endl;
+            head = packed_mesh::Header();
+            return false;
+        }
+        return true;
+    }
+
+    bool checkSubmesh(const std::string& path, const packed_mesh::Submesh& submesh) const
+    {
+        if (fits(submesh.firstIndex, submesh.indexCount, head.indexCount) && submesh.baseVertex >= 0 &&
+            fits((uint64_t)submesh.baseVertex, submesh.vertexCount, head.vertexCount))
+            return true;
+        std::cout << "ERROR::PACKED_MESH::BAD_FILE " << path << ": submesh out of range" << std::endl;
+        return false;
+    }
+
+    static uint64_t align(uint64_t offset)
+    {
+        return (offset + packed_mesh::ALIGNMENT - 1) / packed_mesh::ALIGNMENT * packed_mesh::ALIGNMENT;
+    }
+
+    template <typename Vertex, typename Layout, typename Convert>
+    static bool writeAs(const std::string& path, const std::vector<std::string>& names, const std::vector<MeshData>& meshes, Convert convert)
+    {
+        packed_mesh::Header header = {};
+        header.magic = packed_mesh::MAGIC;
+        header.version = packed_mesh::VERSION;
+        header.vertexStride = (uint32_t)sizeof(Vertex);
+
+        std::vector<packed_mesh::Attribute> attributes;
+        Layout::visit([&attributes](auto attribute) {
+            using A = decltype(attribute);
+            attributes.push_back({A::location, A::type, (uint32_t)A::components, (uint16_t)A::offset, (uint8_t)A::mode, 0});
+        });
+
+        MeshBounds all;
+        size_t largest = 0;
+        std::vector<packed_mesh::Submesh> submeshes;
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            const MeshData& mesh = meshes[i];
+            packed_mesh::Submesh submesh = {};
+            submesh.firstIndex = header.indexCount;
+            submesh.indexCount = (uint32_t)mesh.indices.size();
+            submesh.baseVertex = (int32_t)header.vertexCount;
+            submesh.vertexCount = (uint32_t)mesh.vertices.size();
+            std::memcpy(submesh.minimum, mesh.bounds.minimum, sizeof(submesh.minimum));
+            std::memcpy(submesh.maximum, mesh.bounds.maximum, sizeof(submesh.maximum));
+            std::snprintf(submesh.name, sizeof(submesh.name), "%s", i < names.size() ? names[i].c_str() : "");
+            submeshes.push_back(submesh);
+            all.include(mesh.bounds);
+            header.vertexCount += submesh.vertexCount;
+            header.indexCount += submesh.indexCount;
+            largest = std::max(largest, mesh.vertices.size());
+        }
+        header.indexType = MeshOptimizer::indexType(largest);
+        std::memcpy(header.minimum, all.minimum, sizeof(header.minimum));
+        std::memcpy(header.maximum, all.maximum, sizeof(header.maximum));
+
+        header.attributeCount = (uint32_t)attributes.size();
+        header.submeshCount = (uint32_t)submeshes.size();
+        header.attributeOffset = sizeof(header);
+        header.submeshOffset = header.attributeOffset + attributes.size() * sizeof(packed_mesh::Attribute);
+        header.vertexOffset = align(header.submeshOffset + submeshes.size() * sizeof(packed_mesh::Submesh));
+        header.vertexBytes = (uint64_t)header.vertexCount * sizeof(Vertex);
+        header.indexOffset = align(header.vertexOffset + header.vertexBytes);
+        header.indexBytes = (uint64_t)header.indexCount * MeshOptimizer::indexSize(header.indexType);
+        header.fileSize = header.indexOffset + header.indexBytes;
+
+        // written beside the target and renamed over it, so a failed write never leaves a
+        // half-written mesh behind; the temporary goes away on every failure
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            const char padding[packed_mesh::ALIGNMENT] = {};
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(attributes.data()), (std::streamsize)(attributes.size() * sizeof(packed_mesh::Attribute)));
+            file.write(reinterpret_cast<const char*>(submeshes.data()), (std::streamsize)(submeshes.size() * sizeof(packed_mesh::Submesh)));
+            file.write(padding, (std::streamsize)(header.vertexOffset - (header.submeshOffset + submeshes.size() * sizeof(packed_mesh::Submesh))));
+
+            std::vector<Vertex> vertices;
+            for (const MeshData& mesh : meshes)
+            {
+                vertices.resize(mesh.vertices.size());
+                for (size_t v = 0; v < mesh.vertices.size(); ++v)
+                    convert(mesh.vertices[v], vertices[v]);
+                file.write(reinterpret_cast<const char*>(vertices.data()), (std::streamsize)(vertices.size() * sizeof(Vertex)));
+            }
+            file.write(padding, (std::streamsize)(header.indexOffset - (header.vertexOffset + header.vertexBytes)));
+
+            std::vector<char> indices;
+            for (const MeshData& mesh : meshes)
+            {
+                indices.resize(mesh.indices.size() * MeshOptimizer::indexSize(header.indexType));
+                MeshOptimizer::encodeIndices(indices.data(), mesh.indices.data(), mesh.indices.size(), header.indexType);
+                file.write(indices.data(), (std::streamsize)indices.size());
+            }
+            file.close();
+            if (!file)
+            {
+                std::cout << "ERROR::PACKED_MESH::WRITE_FAILED " << temporary << std::endl;
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::cout << "ERROR::PACKED_MESH::WRITE_FAILED " << path << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif /* PackedMesh_h */
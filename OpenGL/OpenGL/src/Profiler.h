@@ -0,0 +1,353 @@
+//
+//  Profiler.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/2/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <GL/glew.h>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+
+/*
+   Frame profiler. Each frame, and each named section inside it, is timed on the CPU with
+   steady_clock and on the GPU with timer queries:
+
+       profiler.beginFrame();
+       {
+           Profiler::Scope scope(profiler, "draw");
+           glDrawElements(...);
+       }
+       profiler.endFrame();
+
+   Sections use GL_TIME_ELAPSED, which cannot nest, so sections must not overlap each other.
+   The frame as a whole is bracketed with GL_TIMESTAMP counters instead, which may enclose
+   the sections. Queries are buffered LATENCY frames deep and only read back once
+   GL_QUERY_RESULT_AVAILABLE says so; a result that is still not ready after that is dropped
+   rather than waited for. Samples go into fixed-size ring buffers, and report() prints
+   p50/p95/p99 for every section.
+
+   Counters are per-frame tallies of anything else (draws skipped, fragments saved, ...):
+   count() adds to the current frame's value, endFrame() records it, and report() prints
+   p50/p95/p99 per frame and the total of every counter next to the timings.
+ */
+class Profiler
+{
+public:
+    static const int LATENCY = 4;          // frames of queries in flight
+    static const int HISTORY = 1024;       // samples kept per section
+    static const int MAX_SECTIONS = 32;
+    static const int MAX_SCOPES = 64;      // section instances per frame
+    static const int MAX_COUNTERS = 16;
+
+    class Scope
+    {
+    public:
+        Scope(Profiler& profiler, const char* name) : profiler(profiler) { profiler.begin(name); }
+        ~Scope() { profiler.end(); }
+    private:
+        Profiler& profiler;
+    };
+
+    Profiler()
+    {
+        for (Slot& slot : slots)
+        {
+            glGenQueries(2, slot.frameQueries);
+            glGenQueries(MAX_SCOPES, slot.queries);
+        }
+        std::strcpy(sections[0].name, "frame");
+        sectionCount = 1;
+    }
+    ~Profiler()
+    {
+        for (Slot& slot : slots)
+        {
+            glDeleteQueries(2, slot.frameQueries);
+            glDeleteQueries(MAX_SCOPES, slot.queries);
+        }
+    }
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void beginFrame()
+    {
+        Slot& slot = slots[frame % LATENCY];
+        collect(slot);
+        slot.scopeCount = 0;
+        slot.used = true;
+        glQueryCounter(slot.frameQueries[0], GL_TIMESTAMP);
+        frameStart = Clock::now();
+    }
+
+    void endFrame()
+    {
+        Slot& slot = slots[frame % LATENCY];
+        glQueryCounter(slot.frameQueries[1], GL_TIMESTAMP);
+        record(sections[0].cpu, sections[0].cpuCount, milliseconds(Clock::now() - frameStart));
+        for (int i = 0; i < counterCount; ++i)
+        {
+            record(counters[i].values, counters[i].count, (float)counters[i].current);
+            counters[i].current = 0.0;
+        }
+        ++frame;
+    }
+
+    // adds to this frame's value of a counter
+    void count(const char* name, double value)
+    {
+        int counter = findCounter(name);
+        if (counter < 0)
+            return;
+        counters[counter].current += value;
+        counters[counter].total += value;
+    }
+
+    void begin(const char* name)
+    {
+        Slot& slot = slots[frame % LATENCY];
+        active = -1;
+        int section = find(name);
+        if (section < 0 || slot.scopeCount == MAX_SCOPES)
+            return;
+        active = slot.scopeCount++;
+        slot.sections[active] = section;
+        glBeginQuery(GL_TIME_ELAPSED, slot.queries[active]);
+        sectionStart = Clock::now();
+    }
+
+    void end()
+    {
+        if (active < 0)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        Section& section = sections[slots[frame % LATENCY].sections[active]];
+        record(section.cpu, section.cpuCount, milliseconds(Clock::now() - sectionStart));
+        active = -1;
+    }
+
+    // waits for the GPU and reads back every query still in flight, e.g. before stats()
+    void finish()
+    {
+        glFinish();
+        for (int i = 0; i < LATENCY; ++i)
+        {
+            Slot& slot = slots[(frame + i) % LATENCY];
+            collect(slot);
+            slot.used = false;
+        }
+    }
+
+    // GPU results that were still not available LATENCY frames later
+    unsigned long dropped() const { return droppedSamples; }
+
+    // p50/p95/p99 in milliseconds; a section that was never timed reads as all zeros
+    struct Stats
+    {
+        float cpu[3];
+        float gpu[3];
+        unsigned long cpuSamples;
+        unsigned long gpuSamples;
+    };
+    Stats stats(const char* name) const
+    {
+        Stats result = {};
+        for (int i = 0; i < sectionCount; ++i)
+        {
+            if (std::strncmp(sections[i].name, name, sizeof(sections[i].name) - 1) != 0)
+                continue;
+            percentiles(sections[i].cpu, sections[i].cpuCount, result.cpu);
+            percentiles(sections[i].gpu, sections[i].gpuCount, result.gpu);
+            result.cpuSamples = sections[i].cpuCount;
+            result.gpuSamples = sections[i].gpuCount;
+        }
+        return result;
+    }
+
+    void report(std::ostream& out = std::cout) const
+    {
+        out << "PROFILER " << frame << " frames (" << droppedSamples << " GPU samples dropped)\n";
+        out << std::left << std::setw(20) << "section" << std::right
+            << std::setw(10) << "cpu p50" << std::setw(10) << "cpu p95" << std::setw(10) << "cpu p99"
+            << std::setw(10) << "gpu p50" << std::setw(10) << "gpu p95" << std::setw(10) << "gpu p99" << "   (ms)\n";
+        out << std::fixed << std::setprecision(3);
+        for (int i = 0; i < sectionCount; ++i)
+        {
+            const Section& section = sections[i];
+            float cpu[3], gpu[3];
+            percentiles(section.cpu, section.cpuCount, cpu);
+            percentiles(section.gpu, section.gpuCount, gpu);
+            out << std::left << std::setw(20) << section.name << std::right;
+            for (float value : cpu)
+                out << std::setw(10) << value;
+            for (float value : gpu)
+                out << std::setw(10) << value;
+            out << "\n";
+        }
+        if (counterCount > 0)
+        {
+            out << std::left << std::setw(20) << "counter" << std::right
+                << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99"
+                << std::setw(20) << "total" << "   (per frame)\n";
+            for (int i = 0; i < counterCount; ++i)
+            {
+                const Counter& counter = counters[i];
+                float values[3];
+                percentiles(counter.values, counter.count, values);
+                out << std::left << std::setw(20) << counter.name << std::right;
+                for (float value : values)
+                    out << std::setw(10) << (long long)value;
+                out << std::setw(20) << (long long)counter.total << "\n";
+            }
+        }
+        out << std::defaultfloat << std::flush;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Section
+    {
+        char name[32];
+        float cpu[HISTORY];
+        float gpu[HISTORY];
+        unsigned long cpuCount;
+        unsigned long gpuCount;
+    };
+    struct Counter
+    {
+        char name[32];
+        float values[HISTORY];
+        unsigned long count;
+        double current;
+        double total;
+    };
+    struct Slot
+    {
+        GLuint frameQueries[2];
+        GLuint queries[MAX_SCOPES];
+        int sections[MAX_SCOPES];
+        int scopeCount = 0;
+        bool used = false;
+    };
+
+    Section sections[MAX_SECTIONS] = {};
+    int sectionCount = 0;
+    Counter counters[MAX_COUNTERS] = {};
+    int counterCount = 0;
+    Slot slots[LATENCY];
+    unsigned long frame = 0;
+    unsigned long droppedSamples = 0;
+    int active = -1;
+    Clock::time_point frameStart;
+    Clock::time_point sectionStart;
+
+    static float milliseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    static void record(float* ring, unsigned long& count, float value)
+    {
+        ring[count % HISTORY] = value;
+        ++count;
+    }
+
+    int find(const char* name)
+    {
+        for (int i = 0; i < sectionCount; ++i)
+            if (std::strncmp(sections[i].name, name, sizeof(sections[i].name) - 1) == 0)
+                return i;
+        if (sectionCount == MAX_SECTIONS)
+            return -1;
+        std::strncpy(sections[sectionCount].name, name, sizeof(sections[sectionCount].name) - 1);
+        return sectionCount++;
+    }
+
+    int findCounter(const char* name)
+    {
+        for (int i = 0; i < counterCount; ++i)
+            if (std::strncmp(counters[i].name, name, sizeof(counters[i].name) - 1) == 0)
+                return i;
+        if (counterCount == MAX_COUNTERS)
+            return -1;
+        std::strncpy(counters[counterCount].name, name, sizeof(counters[counterCount].name) - 1);
+        return counterCount++;
+    }
+
+    static bool available(GLuint query)
+    {
+        GLuint ready = GL_FALSE;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &ready);
+        return ready == GL_TRUE;
+    }
+
+    // reads back the queries a slot issued LATENCY frames ago, without ever waiting on them
+    void collect(Slot& slot)
+    {
+        if (!slot.used)
+            return;
+        GLuint64 frameTime = 0;
+        if (available(slot.frameQueries[1]))
+        {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(slot.frameQueries[0], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(slot.frameQueries[1], GL_QUERY_RESULT, &end);
+            frameTime = end - start;
+            record(sections[0].gpu, sections[0].gpuCount, (float)frameTime / 1.0e6f);
+        }
+        else
+        {
+            ++droppedSamples;
+        }
+        for (int i = 0; i < slot.scopeCount; ++i)
+        {
+            if (!available(slot.queries[i]))
+            {
+                ++droppedSamples;
+                continue;
+            }
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &elapsed);
+            // some drivers (Mesa llvmpipe) answer the very first elapsed-time query with a raw
+            // timestamp; a section cannot take longer than the frame around it
+            if (frameTime != 0 && elapsed > frameTime)
+            {
+                ++droppedSamples;
+                continue;
+            }
+            Section& section = sections[slot.sections[i]];
+            record(section.gpu, section.gpuCount, (float)elapsed / 1.0e6f);
+        }
+    }
+
+    static void percentiles(const float* ring, unsigned long count, float result[3])
+    {
+        size_t size = (size_t)std::min<unsigned long>(count, HISTORY);
+        if (size == 0)
+        {
+            result[0] = result[1] = result[2] = 0.0f;
+            return;
+        }
+        float sorted[HISTORY];
+        std::copy(ring, ring + size, sorted);
+        const float ranks[3] = {0.50f, 0.95f, 0.99f};
+        for (int i = 0; i < 3; ++i)
+        {
+            size_t index = std::min(size - 1, (size_t)(ranks[i] * (float)(size - 1) + 0.5f));
+            std::nth_element(sorted, sorted + index, sorted + size);
+            result[i] = sorted[index];
+        }
+    }
+};
+
+#endif /* Profiler_h */
@@ -0,0 +1,250 @@
+//
+//  RenderQueue.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/13/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <GL/glew.h>
+
+#include "StateCache.h"
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+
+/*
+   One draw, as recorded by any thread and issued later on the GL thread. Everything the draw
+   needs is in here, so recording never touches GL. indexType GL_NONE draws arrays from first;
+   otherwise count indices are read from indexOffset with first as the base vertex. If uniform
+   is a location, data is uploaded to it with glUniform4fv just before the draw.
+ */
+struct DrawCommand
+{
+    uint64_t key;
+    GLuint program;
+    GLuint vertexArray;
+    GLuint texture;             // bound to unit 0 unless 0
+    GLenum mode;
+    GLenum indexType;
+    GLsizei count;
+    GLint first;
+    GLuint indexOffset;
+    GLint uniform;
+    float data[4];
+};
+
+
+/*
+   64-bit sort keys, most significant field first:
+
+       | layer 4 | program 12 | vertex array 12 | texture 12 | depth 24 |
+
+   Sorting by key draws layer by layer, and within a layer groups draws by program, then
+   vertex array, then texture, so each bind is made once per group; depth only orders draws
+   that share all their state, front to back. GL names wider than their field share a value
+   with another name, which costs a bind but never a wrong draw - the command carries the real
+   names. For back-to-front (blended) layers pass 1 - depth.
+ */
+namespace SortKey {
+
+const int LAYER_BITS = 4;
+const int PROGRAM_BITS = 12;
+const int VERTEX_ARRAY_BITS = 12;
+const int TEXTURE_BITS = 12;
+const int DEPTH_BITS = 24;
+
+inline uint64_t field(uint64_t value, int bits, int shift)
+{
+    return (value & ((uint64_t(1) << bits) - 1)) << shift;
+}
+
+// depth in [0, 1], 0 nearest
+inline uint64_t make(unsigned layer, GLuint program, GLuint vertexArray, GLuint texture, float depth)
+{
+    depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+    uint64_t quantized = (uint64_t)(depth * (float)((1 << DEPTH_BITS) - 1));
+    return field(layer, LAYER_BITS, 60)
+         | field(program, PROGRAM_BITS, 48)
+         | field(vertexArray, VERTEX_ARRAY_BITS, 36)
+         | field(texture, TEXTURE_BITS, 24)
+         | field(quantized, DEPTH_BITS, 0);
+}
+
+} // namespace SortKey
+
+
+/*
+   A fixed number of DrawCommands for one thread. The memory is allocated once, so recording
+   is a copy; a full buffer drops the command and counts it. The counters sit on a cache line
+   of their own, so threads recording side by side never write to the same line (over-aligned
+   members in a std::vector need C++17).
+ */
+class CommandBuffer
+{
+public:
+    explicit CommandBuffer(size_t capacity) : commands(capacity) {}
+
+    bool record(const DrawCommand& command)
+    {
+        if (used == commands.size())
+        {
+            ++dropped;
+            return false;
+        }
+        commands[used++] = command;
+        return true;
+    }
+
+    void clear()
+    {
+        used = 0;
+        dropped = 0;
+    }
+
+    size_t size() const { return used; }
+    size_t capacity() const { return commands.size(); }
+    unsigned long droppedCount() const { return dropped; }
+    const DrawCommand& operator[](size_t i) const { return commands[i]; }
+
+private:
+    std::vector<DrawCommand> commands;
+    alignas(64) size_t used = 0;
+    unsigned long dropped = 0;
+};
+
+
+/*
+   Draws recorded in parallel and submitted sorted. Each recording thread writes only to its
+   own CommandBuffer, so recording needs no locks; the GL thread waits for the recorders, then
+   submit() radix-sorts every command by key and issues them through a StateCache, which drops
+   the binds the sort made redundant:
+
+       queue.clear();
+       ... thread t: queue.buffer(t).record(command) for its part of the scene ...
+       ... wait for the threads to finish ...
+       queue.submit(state);
+
+   Nothing allocates after construction.
+ */
+class RenderQueue
+{
+public:
+    struct Stats
+    {
+        unsigned long frames;
+        unsigned long commands;         // in the last submit()
+        unsigned long dropped;          // in the last submit(), because a buffer was full
+        double sortMilliseconds;        // total over all frames
+    };
+
+    RenderQueue(unsigned threads, size_t commandsPerThread)
+        : entries(threads * commandsPerThread), scratch(threads * commandsPerThread)
+    {
+        buffers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+            buffers.emplace_back(commandsPerThread);
+    }
+
+    unsigned threads() const { return (unsigned)buffers.size(); }
+    CommandBuffer& buffer(unsigned thread) { return buffers[thread]; }
+    const Stats& stats() const { return counters; }
+
+    // empties every buffer; call on the GL thread before recording starts
+    void clear()
+    {
+        for (CommandBuffer& buffer : buffers)
+            buffer.clear();
+    }
+
+    // sorts what was recorded and draws it; every recording thread must have finished
+    // ------------------------------------------------------------------------
+    void submit(StateCache& state)
+    {
+        auto start = std::chrono::steady_clock::now();
+        size_t count = 0;
+        counters.dropped = 0;
+        for (const CommandBuffer& buffer : buffers)
+        {
+            for (size_t i = 0; i < buffer.size(); ++i)
+                entries[count++] = {buffer[i].key, &buffer[i]};
+            counters.dropped += buffer.droppedCount();
+        }
+        sort(count);
+        counters.sortMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (size_t i = 0; i < count; ++i)
+            issue(state, *entries[i].command);
+
+        counters.commands = (unsigned long)count;
+        ++counters.frames;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        const DrawCommand* command;
+    };
+
+    std::vector<CommandBuffer> buffers;
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch;
+    Stats counters = Stats();
+
+    // least significant digit first, a byte per pass; one pass counts all eight digits and a
+    // digit every key shares (e.g. the layer, when there is one) is skipped
+    void sort(size_t count)
+    {
+        size_t histogram[8][256] = {};
+        for (size_t i = 0; i < count; ++i)
+            for (int digit = 0; digit < 8; ++digit)
+                ++histogram[digit][(entries[i].key >> (digit * 8)) & 0xFF];
+
+        Entry* from = entries.data();
+        Entry* to = scratch.data();
+        for (int digit = 0; digit < 8; ++digit)
+        {
+            size_t* buckets = histogram[digit];
+            if (count == 0 || buckets[(from[0].key >> (digit * 8)) & 0xFF] == count)
+                continue;
+            size_t offset = 0;
+            for (int b = 0; b < 256; ++b)
+            {
+                size_t size = buckets[b];
+                buckets[b] = offset;
+                offset += size;
+            }
+            for (size_t i = 0; i < count; ++i)
+                to[buckets[(from[i].key >> (digit * 8)) & 0xFF]++] = from[i];
+            Entry* swap = from;
+            from = to;
+            to = swap;
+        }
+        if (from != entries.data())
+            std::copy(from, from + count, entries.data());
+    }
+
+    static void issue(StateCache& state, const DrawCommand& command)
+    {
+        state.useProgram(command.program);
+        state.bindVertexArray(command.vertexArray);
+        if (command.texture != 0)
+            state.bindTexture(0, GL_TEXTURE_2D, command.texture);
+        if (command.uniform >= 0)
+            glUniform4fv(command.uniform, 1, command.data);
+        if (command.indexType == GL_NONE)
+            glDrawArrays(command.mode, command.first, command.count);
+        else
+            glDrawElementsBaseVertex(command.mode, command.count, command.indexType, (const void*)(uintptr_t)command.indexOffset, command.first);
+    }
+};
+
+#endif /* RenderQueue_h */
@@ -0,0 +1,286 @@
+//
+//  StateCache.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/12/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+#include <GL/glew.h>
+
+#include <iostream>
+
+
+/*
+   Shadows the GL state the render loops touch - program, vertex array, buffer bindings,
+   texture units, blend, depth and viewport - and drops calls that would set what is already
+   set. Every call is counted as issued or skipped, per frame and in total:
+
+       state.beginFrame();
+       state.useProgram(shader.ID);
+       state.bindVertexArray(VAO);
+       glDrawArrays(...);
+
+   The cache only knows about changes made through it. After code that calls GL directly
+   (or deletes a bound object), call invalidate() and the next call of each kind goes through.
+   The element array binding belongs to the vertex array, so it is forgotten whenever the
+   vertex array changes.
+ */
+class StateCache
+{
+public:
+    static const int MAX_TEXTURE_UNITS = 32;
+
+    struct Counters
+    {
+        unsigned long issued;
+        unsigned long skipped;
+    };
+
+    StateCache() { invalidate(); }
+
+    // forgets everything, so the next call of each kind reaches the driver
+    void invalidate()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        for (GLuint& buffer : buffers)
+            buffer = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (auto& unit : textures)
+            for (GLuint& texture : unit)
+                texture = UNKNOWN;
+        for (int& enabled : capabilities)
+            enabled = -1;
+        blendSource = blendDestination = UNKNOWN;
+        depthFunction = UNKNOWN;
+        depthWrite = -1;
+        viewportKnown = false;
+    }
+
+    // starts counting a new frame; the previous frame's counts stay readable in lastFrame()
+    void beginFrame()
+    {
+        previous = current;
+        current = Counters();
+    }
+    const Counters& lastFrame() const { return previous; }
+    const Counters& thisFrame() const { return current; }
+    const Counters& total() const { return totals; }
+
+    void printStats() const
+    {
+        std::cout << "STATE_CACHE issued: " << totals.issued << " skipped: " << totals.skipped
+                  << " (last frame issued: " << previous.issued << " skipped: " << previous.skipped << ")" << std::endl;
+    }
+
+    void useProgram(GLuint id)
+    {
+        if (change(program, id))
+            glUseProgram(id);
+    }
+
+    void bindVertexArray(GLuint id)
+    {
+        if (change(vertexArray, id))
+        {
+            glBindVertexArray(id);
+            buffers[ELEMENT_ARRAY] = UNKNOWN;
+        }
+    }
+
+    void bindBuffer(GLenum target, GLuint id)
+    {
+        int slot = bufferSlot(target);
+        if (slot < 0 ? issue() : change(buffers[slot], id))
+            glBindBuffer(target, id);
+    }
+
+    // binds texture to unit, switching the active unit only when needed
+    void bindTexture(GLuint unit, GLenum target, GLuint id)
+    {
+        int slot = textureSlot(target);
+        if (unit >= (GLuint)MAX_TEXTURE_UNITS || slot < 0)
+        {
+            activeTexture(unit);
+            issue();
+            glBindTexture(target, id);
+            return;
+        }
+        if (textures[unit][slot] == id)
+        {
+            skip();
+            return;
+        }
+        activeTexture(unit);
+        textures[unit][slot] = id;
+        issue();
+        glBindTexture(target, id);
+    }
+
+    void enable(GLenum capability) { set(capability, true); }
+    void disable(GLenum capability) { set(capability, false); }
+
+    void blendFunc(GLenum source, GLenum destination)
+    {
+        if (blendSource == source && blendDestination == destination)
+        {
+            skip();
+            return;
+        }
+        blendSource = source;
+        blendDestination = destination;
+        issue();
+        glBlendFunc(source, destination);
+    }
+
+    void depthFunc(GLenum function)
+    {
+        if (change(depthFunction, function))
+            glDepthFunc(function);
+    }
+
+    void depthMask(GLboolean write)
+    {
+        if (depthWrite == (int)write)
+        {
+            skip();
+            return;
+        }
+        depthWrite = (int)write;
+        issue();
+        glDepthMask(write);
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        if (viewportKnown && viewportRect[0] == x && viewportRect[1] == y && viewportRect[2] == width && viewportRect[3] == height)
+        {
+            skip();
+            return;
+        }
+        viewportKnown = true;
+        viewportRect[0] = x;
+        viewportRect[1] = y;
+        viewportRect[2] = width;
+        viewportRect[3] = height;
+        issue();
+        glViewport(x, y, width, height);
+    }
+
+private:
+    // never a valid GL name or enum, so the first call always goes through
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    enum { ARRAY, ELEMENT_ARRAY, UNIFORM, COPY_READ, COPY_WRITE, PIXEL_PACK, PIXEL_UNPACK, DRAW_INDIRECT, BUFFER_TARGETS };
+    enum { TEXTURE_2D_SLOT, TEXTURE_3D_SLOT, TEXTURE_CUBE_SLOT, TEXTURE_ARRAY_SLOT, TEXTURE_TARGETS };
+    enum { BLEND, DEPTH_TEST, CULL_FACE, STENCIL_TEST, SCISSOR_TEST, CAPABILITIES };
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint buffers[BUFFER_TARGETS];
+    GLuint activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    int capabilities[CAPABILITIES];     // -1 unknown, 0 disabled, 1 enabled
+    GLenum blendSource, blendDestination;
+    GLenum depthFunction;
+    int depthWrite;
+    bool viewportKnown;
+    GLint viewportRect[4];
+
+    Counters current = Counters();
+    Counters previous = Counters();
+    Counters totals = Counters();
+
+    bool issue()
+    {
+        ++current.issued;
+        ++totals.issued;
+        return true;
+    }
+    void skip()
+    {
+        ++current.skipped;
+        ++totals.skipped;
+    }
+    // records value and returns true if it differs from what is cached
+    bool change(GLuint& cached, GLuint value)
+    {
+        if (cached == value)
+        {
+            skip();
+            return false;
+        }
+        cached = value;
+        return issue();
+    }
+
+    void activeTexture(GLuint unit)
+    {
+        if (change(activeUnit, unit))
+            glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    void set(GLenum capability, bool enabled)
+    {
+        int slot = capabilitySlot(capability);
+        if (slot >= 0 && capabilities[slot] == (int)enabled)
+        {
+            skip();
+            return;
+        }
+        if (slot >= 0)
+            capabilities[slot] = (int)enabled;
+        issue();
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    static int bufferSlot(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_ARRAY_BUFFER: return ARRAY;
+            case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT_ARRAY;
+            case GL_UNIFORM_BUFFER: return UNIFORM;
+            case GL_COPY_READ_BUFFER: return COPY_READ;
+            case GL_COPY_WRITE_BUFFER: return COPY_WRITE;
+            case GL_PIXEL_PACK_BUFFER: return PIXEL_PACK;
+            case GL_PIXEL_UNPACK_BUFFER: return PIXEL_UNPACK;
+            case GL_DRAW_INDIRECT_BUFFER: return DRAW_INDIRECT;
+            default: return -1;
+        }
+    }
+
+    static int textureSlot(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_TEXTURE_2D: return TEXTURE_2D_SLOT;
+            case GL_TEXTURE_3D: return TEXTURE_3D_SLOT;
+            case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_SLOT;
+            case GL_TEXTURE_2D_ARRAY: return TEXTURE_ARRAY_SLOT;
+            default: return -1;
+        }
+    }
+
+    static int capabilitySlot(GLenum capability)
+    {
+        switch (capability)
+        {
+            case GL_BLEND: return BLEND;
+            case GL_DEPTH_TEST: return DEPTH_TEST;
+            case GL_CULL_FACE: return CULL_FACE;
+            case GL_STENCIL_TEST: return STENCIL_TEST;
+            case GL_SCISSOR_TEST: return SCISSOR_TEST;
+            default: return -1;
+        }
+    }
+};
+
+#endif /* StateCache_h */
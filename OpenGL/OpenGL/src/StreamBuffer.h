@@ -0,0 +1,209 @@
+//
+//  StreamBuffer.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/11/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <GL/glew.h>
+
+#include <iostream>
+#include <chrono>
+
+
+/*
+   A buffer for data rewritten every frame, without glBufferData orphaning or glBufferSubData
+   and the implicit synchronisation they can cause. The buffer is split into REGIONS frame
+   regions written round-robin; the CPU fills one while the GPU may still be reading the
+   others:
+
+       void* data = stream.reserve(bytes, sizeof(Vertex));
+       ... write up to bytes into data ...
+       GLintptr offset = stream.commit(written);    // where the data landed in buffer()
+       glDrawElementsBaseVertex(..., (GLint)(offset / sizeof(Vertex)));
+       ...
+       stream.endFrame();                           // once per frame, after the last draw
+
+   endFrame() puts a fence behind the region just written and moves on to the next one,
+   waiting for that region's fence first. A frame that needs more than one region moves on
+   early the same way. Any wait that actually blocks is a stall - the CPU has run REGIONS
+   frames ahead of the GPU - and shows up in stats().
+
+   With GL 4.4 or ARB_buffer_storage the buffer is created with glBufferStorage and stays
+   mapped (persistent and coherent), so reserve() is pointer arithmetic. Elsewhere (macOS
+   stops at 4.1) each reserve() maps its range with GL_MAP_UNSYNCHRONIZED_BIT and commit()
+   unmaps it; the fences make that just as safe.
+ */
+class StreamBuffer
+{
+public:
+    static const int REGIONS = 3;
+
+    struct Stats
+    {
+        unsigned long frames;
+        unsigned long stalls;          // fence waits that blocked
+        double stallMilliseconds;
+        unsigned long earlyAdvances;   // regions left before the end of a frame because they were full
+        unsigned long long bytes;
+    };
+
+    StreamBuffer(GLenum target, GLsizeiptr regionSize, bool allowPersistent = true) : target(target), regionSize(regionSize)
+    {
+        persistentMapping = allowPersistent && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+        glGenBuffers(1, &id);
+        glBindBuffer(target, id);
+        if (persistentMapping)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(target, regionSize * REGIONS, nullptr, flags);
+            base = static_cast<char*>(glMapBufferRange(target, 0, regionSize * REGIONS, flags));
+            if (base == nullptr)
+            {
+                // storage is immutable now, so start over with a plain buffer
+                std::cout << "WARNING::STREAM_BUFFER persistent mapping failed, using unsynchronized maps" << std::endl;
+                glBindBuffer(target, 0);
+                glDeleteBuffers(1, &id);
+                glGenBuffers(1, &id);
+                glBindBuffer(target, id);
+                persistentMapping = false;
+            }
+        }
+        if (!persistentMapping)
+            glBufferData(target, regionSize * REGIONS, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(target, 0);
+    }
+    ~StreamBuffer()
+    {
+        for (GLsync fence : fences)
+            if (fence != nullptr)
+                glDeleteSync(fence);
+        glBindBuffer(target, id);
+        if (persistentMapping || mapped != nullptr)
+            glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+        glDeleteBuffers(1, &id);
+    }
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    GLuint buffer() const { return id; }
+    bool persistent() const { return persistentMapping; }
+    const Stats& stats() const { return counters; }
+
+    // returns memory for up to size bytes, starting at a multiple of alignment within the
+    // buffer (e.g. the vertex stride, so the offset converts to a base vertex). Returns
+    // nullptr if size does not fit in a region at all.
+    // ------------------------------------------------------------------------
+    void* reserve(GLsizeiptr size, GLsizeiptr alignment = 4)
+    {
+        GLintptr start = align(regionStart() + cursor, alignment);
+        if (start + size > regionStart() + regionSize)
+        {
+            if (align(regionStart(), alignment) + size > regionStart() + regionSize)
+            {
+                std::cout << "ERROR::STREAM_BUFFER " << size << " bytes do not fit in a " << regionSize << " byte region" << std::endl;
+                return nullptr;
+            }
+            advance();
+            ++counters.earlyAdvances;
+            start = align(regionStart(), alignment);
+        }
+        reserved = start;
+        reservedSize = size;
+        if (persistentMapping)
+            return base + start;
+
+        // the fences already guarantee the GPU is done with this range
+        glBindBuffer(target, id);
+        mapped = glMapBufferRange(target, start, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        glBindBuffer(target, 0);
+        return mapped;
+    }
+
+    // ends the last reserve(); size is how much of it was written. Returns the data's byte
+    // offset in buffer().
+    // ------------------------------------------------------------------------
+    GLintptr commit(GLsizeiptr size)
+    {
+        if (!persistentMapping && mapped != nullptr)
+        {
+            glBindBuffer(target, id);
+            glUnmapBuffer(target);
+            glBindBuffer(target, 0);
+            mapped = nullptr;
+        }
+        size = size < reservedSize ? size : reservedSize;
+        cursor = reserved + size - regionStart();
+        counters.bytes += (unsigned long long)size;
+        return reserved;
+    }
+
+    // fences the region written this frame and moves on to the next one
+    // ------------------------------------------------------------------------
+    void endFrame()
+    {
+        advance();
+        ++counters.frames;
+    }
+
+private:
+    GLenum target;
+    GLsizeiptr regionSize;
+    GLuint id = 0;
+    bool persistentMapping = false;
+    char* base = nullptr;
+    void* mapped = nullptr;
+    GLsync fences[REGIONS] = {};
+    int region = 0;
+    GLintptr cursor = 0;
+    GLintptr reserved = 0;
+    GLsizeiptr reservedSize = 0;
+    Stats counters = Stats();
+
+    GLintptr regionStart() const { return (GLintptr)region * regionSize; }
+
+    static GLintptr align(GLintptr offset, GLsizeiptr alignment)
+    {
+        return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+    }
+
+    void advance()
+    {
+        if (cursor > 0)
+        {
+            if (fences[region] != nullptr)
+                glDeleteSync(fences[region]);
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        region = (region + 1) % REGIONS;
+        cursor = 0;
+        wait(fences[region]);
+    }
+
+    void wait(GLsync& fence)
+    {
+        if (fence == nullptr)
+            return;
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            // the GPU is still reading this region: the CPU got REGIONS frames ahead
+            auto start = std::chrono::steady_clock::now();
+            do
+            {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+            ++counters.stalls;
+            counters.stallMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+};
+
+#endif /* StreamBuffer_h */
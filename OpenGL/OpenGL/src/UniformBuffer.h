@@ -0,0 +1,186 @@
+//
+//  UniformBuffer.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/12/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <GL/glew.h>
+
+#include "StreamBuffer.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+
+/*
+   Building blocks for C++ structs that match a GLSL "layout(std140) uniform" block byte for
+   byte. Each type carries its std140 base alignment, so the compiler lays the struct out the
+   way the GL does; the STD140_* macros then pin every offset with a static_assert:
+
+       // layout(std140) uniform Frame { mat4 viewProjection; vec4 color; float time; };
+       struct FrameBlock
+       {
+           std140::Mat4 viewProjection;
+           std140::Vec4 color;
+           float time;
+           float padding[3];
+       };
+       STD140_OFFSET(FrameBlock, viewProjection, 0);
+       STD140_OFFSET(FrameBlock, color, 64);
+       STD140_OFFSET(FrameBlock, time, 80);
+       STD140_SIZE(FrameBlock, 96);
+
+   Scalars are plain float/int. A Vec3 is padded to 16 bytes here, whereas GLSL packs a
+   following scalar into its last 4 bytes; the offset asserts catch that case, and a Vec4 or
+   an explicit float after three floats avoids it.
+ */
+namespace std140 {
+
+struct alignas(8) Vec2
+{
+    float x, y;
+    Vec2() = default;
+    Vec2(float x, float y) : x(x), y(y) {}
+};
+
+struct alignas(16) Vec3
+{
+    float x, y, z;
+    Vec3() = default;
+    Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+};
+
+struct alignas(16) Vec4
+{
+    float x, y, z, w;
+    Vec4() = default;
+    Vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+// column major, like GLSL and glm: set(glm::value_ptr(matrix))
+struct alignas(16) Mat4
+{
+    Vec4 columns[4];
+    void set(const float* values) { std::memcpy(columns, values, sizeof(columns)); }
+};
+
+// array elements are rounded up to 16 bytes each
+template <typename T, size_t N>
+struct alignas(16) Array
+{
+    struct alignas(16) Element { T value; };
+    Element elements[N];
+    T& operator[](size_t i) { return elements[i].value; }
+    const T& operator[](size_t i) const { return elements[i].value; }
+};
+
+static_assert(sizeof(Vec2) == 8 && sizeof(Vec4) == 16 && sizeof(Mat4) == 64, "std140 types are misaligned");
+static_assert(sizeof(Array<float, 4>) == 64, "std140 array stride must be 16 bytes");
+
+} // namespace std140
+
+#define STD140_OFFSET(Block, member, offset) \
+    static_assert(offsetof(Block, member) == (offset), #Block "::" #member " is not at std140 offset " #offset)
+#define STD140_SIZE(Block, size) \
+    static_assert(sizeof(Block) == (size) && (size) % 16 == 0, #Block " must be " #size " bytes, a multiple of 16")
+
+
+/*
+   Shared uniform blocks, uploaded once per frame and seen by every program that declares
+   them. Each block is tied to a fixed binding point; attach() points a program's block of
+   that name at it, and upload() writes the data into the next range of a StreamBuffer ring
+   and binds that range with glBindBufferRange. Programs never need glUniform* calls for the
+   block, however many of them draw with it.
+
+       uniforms.declare<FrameBlock>("Frame", 0);
+       uniforms.attach(program);                   // once per linked program
+       ...
+       uniforms.upload(0, frame);                  // every frame, before drawing
+       ...
+       uniforms.endFrame();                        // after the frame's last draw
+ */
+class UniformBuffers
+{
+public:
+    explicit UniformBuffers(GLsizeiptr bytesPerFrame = 64 * 1024) : ring(GL_UNIFORM_BUFFER, bytesPerFrame)
+    {
+        GLint value = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+        alignment = value > 0 ? value : 256;
+    }
+
+    template <typename Block>
+    void declare(const std::string& name, GLuint binding)
+    {
+        static_assert(sizeof(Block) % 16 == 0, "std140 blocks are a multiple of 16 bytes");
+        blocks.push_back({name, binding, (GLsizeiptr)sizeof(Block)});
+    }
+
+    // binds every declared block the program uses to its binding point. Call again after
+    // relinking or loading a program binary, both reset the bindings.
+    // ------------------------------------------------------------------------
+    void attach(GLuint program) const
+    {
+        for (const Declaration& block : blocks)
+        {
+            GLuint index = glGetUniformBlockIndex(program, block.name.c_str());
+            if (index == GL_INVALID_INDEX)
+                continue;
+            GLint size = 0;
+            glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+            if (size > block.size)
+                std::cout << "ERROR::UNIFORM_BUFFER::SIZE_MISMATCH block " << block.name << " is " << size << " bytes in the shader but " << block.size << " in C++" << std::endl;
+            glUniformBlockBinding(program, index, block.binding);
+        }
+    }
+
+    template <typename Block>
+    void upload(GLuint binding, const Block& data)
+    {
+        const Declaration* block = find(binding);
+        if (block == nullptr || block->size != (GLsizeiptr)sizeof(Block))
+        {
+            std::cout << "ERROR::UNIFORM_BUFFER::UNDECLARED_BLOCK at binding " << binding << std::endl;
+            return;
+        }
+        void* memory = ring.reserve((GLsizeiptr)sizeof(Block), alignment);
+        if (memory == nullptr)
+            return;
+        std::memcpy(memory, &data, sizeof(Block));
+        GLintptr offset = ring.commit((GLsizeiptr)sizeof(Block));
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, ring.buffer(), offset, (GLsizeiptr)sizeof(Block));
+    }
+
+    void endFrame() { ring.endFrame(); }
+    const StreamBuffer::Stats& stats() const { return ring.stats(); }
+
+private:
+    struct Declaration
+    {
+        std::string name;
+        GLuint binding;
+        GLsizeiptr size;
+    };
+
+    StreamBuffer ring;
+    GLsizeiptr alignment = 256;
+    std::vector<Declaration> blocks;
+
+    const Declaration* find(GLuint binding) const
+    {
+        for (const Declaration& block : blocks)
+            if (block.binding == binding)
+                return &block;
+        return nullptr;
+    }
+};
+
+#endif /* UniformBuffer_h */
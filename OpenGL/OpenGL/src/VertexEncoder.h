@@ -0,0 +1,302 @@
+//
+//  VertexEncoder.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef VERTEX_ENCODER_H
+#define VERTEX_ENCODER_H
+
+#include "VertexLayout.h"
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VERTEX_ENCODER_SSE2 1
+#if defined(__F16C__)
+#include <immintrin.h>
+#define VERTEX_ENCODER_F16C 1
+#endif
+#endif
+
+
+/*
+   Bulk conversion of float vertex data into the compressed attribute formats of
+   VertexLayout.h:
+
+       half floats             positions                   2 bytes per component
+       unsigned normalized 8   colors                      1 byte per component
+       unsigned normalized 16  texture coordinates         2 bytes per component
+       signed 2_10_10_10_REV   normals (w = 0)             4 bytes for all of x, y, z
+
+   Each encoder reads count elements of tightly packed floats and writes them stride bytes
+   apart, so it can fill one member of an interleaved vertex array:
+
+       VertexEncoder::encodeHalf(positions, count, 4, &vertices[0].position, sizeof(Vertex));
+
+   Four to sixteen values are converted per instruction with SSE2 (plus F16C for halves, when
+   the compiler targets it); simdPath() says which. Other targets use the scalar versions,
+   which give the same results, including round-to-nearest-even and F16C's NaNs, and handle
+   the tails. Values outside a normalized format's range are clamped.
+ */
+namespace VertexEncoder {
+
+inline const char* simdPath()
+{
+#if defined(VERTEX_ENCODER_F16C)
+    return "SSE2+F16C";
+#elif defined(VERTEX_ENCODER_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// NaN clamps to low, as the SIMD min/max do
+inline float clamp(float value, float low, float high)
+{
+    return value > low ? (value < high ? value : high) : low;
+}
+
+
+// scalar conversions, one value at a time
+// ------------------------------------------------------------------------
+inline uint16_t toHalf(float value)
+{
+    uint32_t f;
+    std::memcpy(&f, &value, 4);
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+    uint16_t half;
+    if (f >= 0x47800000u)
+    {
+        // too large for a half: infinity, or for NaN a quiet NaN keeping the top of the
+        // payload, as F16C does
+        half = f > 0x7F800000u ? (uint16_t)(0x7E00 | ((f >> 13) & 0x3FF)) : 0x7C00;
+    }
+    else if (f < 0x38800000u)
+    {
+        // subnormal or zero: let the float adder do the rounding
+        const uint32_t magicBits = 0x3F000000u;
+        float magic, sum;
+        std::memcpy(&magic, &magicBits, 4);
+        std::memcpy(&sum, &f, 4);
+        sum += magic;
+        uint32_t bits;
+        std::memcpy(&bits, &sum, 4);
+        half = (uint16_t)(bits - magicBits);
+    }
+    else
+    {
+        // rebias the exponent and round the mantissa to nearest even
+        uint32_t odd = (f >> 13) & 1;
+        f += 0xC8000000u + 0xFFF + odd;
+        half = (uint16_t)(f >> 13);
+    }
+    return (uint16_t)(half | (sign >> 16));
+}
+
+inline float fromHalf(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0x1F)
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    else if (exponent != 0)
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else
+    {
+        float value = (float)mantissa * (1.0f / 16777216.0f);   // mantissa * 2^-24
+        return sign != 0 ? -value : value;
+    }
+    float value;
+    std::memcpy(&value, &bits, 4);
+    return value;
+}
+
+inline uint8_t toUnorm8(float value) { return (uint8_t)std::lrint(clamp(value, 0.0f, 1.0f) * 255.0f); }
+inline uint16_t toUnorm16(float value) { return (uint16_t)std::lrint(clamp(value, 0.0f, 1.0f) * 65535.0f); }
+
+inline uint32_t toSnorm10(float value) { return (uint32_t)std::lrint(clamp(value, -1.0f, 1.0f) * 511.0f) & 0x3FF; }
+inline uint32_t toSnorm2101010(const float* xyz) { return toSnorm10(xyz[0]) | (toSnorm10(xyz[1]) << 10) | (toSnorm10(xyz[2]) << 20); }
+
+
+namespace detail {
+
+// contiguous blocks: n values in, n values out; the SIMD loops leave the tail to the scalars
+// ------------------------------------------------------------------------
+inline void halfBlock(const float* source, uint16_t* destination, size_t n)
+{
+    size_t i = 0;
+#if defined(VERTEX_ENCODER_F16C)
+    for (; i + 4 <= n; i += 4)
+        _mm_storel_epi64((__m128i*)(destination + i), _mm_cvtps_ph(_mm_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(VERTEX_ENCODER_SSE2)
+    // the scalar toHalf, four lanes at a time
+    const __m128i signMask = _mm_set1_epi32((int)0x80000000u);
+    const __m128i overflow = _mm_set1_epi32(0x47800000);
+    const __m128i infinity = _mm_set1_epi32(0x7F800000);
+    const __m128i subnormal = _mm_set1_epi32(0x38800000);
+    const __m128i magic = _mm_set1_epi32(0x3F000000);
+    const __m128i bias = _mm_set1_epi32((int)(0xC8000000u + 0xFFF));
+    const __m128i one = _mm_set1_epi32(1);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i packed[2];
+        for (int half = 0; half < 2; ++half)
+        {
+            __m128i f = _mm_castps_si128(_mm_loadu_ps(source + i + half * 4));
+            __m128i sign = _mm_and_si128(f, signMask);
+            f = _mm_xor_si128(f, sign);
+            // compares are signed, but with the sign bit cleared every value is positive
+            __m128i isSpecial = _mm_cmpgt_epi32(f, _mm_sub_epi32(overflow, one));
+            __m128i isNaN = _mm_cmpgt_epi32(f, infinity);
+            __m128i isSmall = _mm_cmpgt_epi32(subnormal, f);
+            __m128i payload = _mm_or_si128(_mm_set1_epi32(0x200), _mm_and_si128(_mm_srli_epi32(f, 13), _mm_set1_epi32(0x3FF)));
+            __m128i special = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNaN, payload));
+            __m128i small = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(f), _mm_castsi128_ps(magic))), magic);
+            __m128i odd = _mm_and_si128(_mm_srli_epi32(f, 13), one);
+            __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(f, bias), odd), 13);
+            __m128i result = _mm_or_si128(_mm_and_si128(isSmall, small), _mm_andnot_si128(isSmall, normal));
+            result = _mm_or_si128(_mm_and_si128(isSpecial, special), _mm_andnot_si128(isSpecial, result));
+            result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+            // sign-extend the low 16 bits so the saturating pack keeps them as they are
+            packed[half] = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+        }
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packs_epi32(packed[0], packed[1]));
+    }
+#endif
+    for (; i < n; ++i)
+        destination[i] = toHalf(source[i]);
+}
+
+inline void unorm8Block(const float* source, uint8_t* destination, size_t n)
+{
+    size_t i = 0;
+#if defined(VERTEX_ENCODER_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 oneF = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v[4];
+        for (int j = 0; j < 4; ++j)
+            v[j] = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + j * 4), zero), oneF), scale));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3])));
+    }
+#endif
+    for (; i < n; ++i)
+        destination[i] = toUnorm8(source[i]);
+}
+
+inline void unorm16Block(const float* source, uint16_t* destination, size_t n)
+{
+    size_t i = 0;
+#if defined(VERTEX_ENCODER_SSE2)
+    // SSE2 only packs to signed 16 bits, so shift the range down by 32768 and back
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 oneF = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(65535.0f);
+    const __m128i offset = _mm_set1_epi32(32768);
+    const __m128i flip = _mm_set1_epi16((short)0x8000);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i a = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), zero), oneF), scale)), offset);
+        __m128i b = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + 4), zero), oneF), scale)), offset);
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_xor_si128(_mm_packs_epi32(a, b), flip));
+    }
+#endif
+    for (; i < n; ++i)
+        destination[i] = toUnorm16(source[i]);
+}
+
+// n xyz triples in, n packed values out
+inline void snorm2101010Block(const float* source, uint32_t* destination, size_t n)
+{
+    size_t i = 0;
+#if defined(VERTEX_ENCODER_SSE2)
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(511.0f);
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    for (; i + 4 <= n; i += 4)
+    {
+        const float* p = source + i * 3;
+        __m128i x = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_setr_ps(p[0], p[3], p[6], p[9]), low), high), scale)), mask);
+        __m128i y = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_setr_ps(p[1], p[4], p[7], p[10]), low), high), scale)), mask);
+        __m128i z = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_setr_ps(p[2], p[5], p[8], p[11]), low), high), scale)), mask);
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_or_si128(x, _mm_or_si128(_mm_slli_epi32(y, 10), _mm_slli_epi32(z, 20))));
+    }
+#endif
+    for (; i < n; ++i)
+        destination[i] = toSnorm2101010(source + i * 3);
+}
+
+// converts count elements, inputs floats in and outputs values out each, a block at a time;
+// block(source, destination, n) converts n elements. The results land stride bytes apart.
+template <typename Out, typename Block>
+void encode(const float* source, size_t count, size_t inputs, size_t outputs, void* destination, size_t stride, Block block)
+{
+    const size_t elementSize = sizeof(Out) * outputs;
+    char* out = static_cast<char*>(destination);
+    if (stride == elementSize)
+    {
+        block(source, reinterpret_cast<Out*>(out), count);
+        return;
+    }
+    const size_t BLOCK = 256;
+    Out converted[BLOCK * 4];
+    for (size_t first = 0; first < count; first += BLOCK)
+    {
+        size_t n = count - first < BLOCK ? count - first : BLOCK;
+        block(source + first * inputs, converted, n);
+        for (size_t i = 0; i < n; ++i)
+            std::memcpy(out + (first + i) * stride, converted + i * outputs, elementSize);
+    }
+}
+
+} // namespace detail
+
+
+// bulk conversions: count elements of components (1 to 4) floats each
+// ------------------------------------------------------------------------
+inline void encodeHalf(const float* source, size_t count, int components, void* destination, size_t stride)
+{
+    size_t n = (size_t)components;
+    detail::encode<uint16_t>(source, count, n, n, destination, stride, [n](const float* in, uint16_t* out, size_t elements) {
+        detail::halfBlock(in, out, elements * n);
+    });
+}
+
+inline void encodeUnorm8(const float* source, size_t count, int components, void* destination, size_t stride)
+{
+    size_t n = (size_t)components;
+    detail::encode<uint8_t>(source, count, n, n, destination, stride, [n](const float* in, uint8_t* out, size_t elements) {
+        detail::unorm8Block(in, out, elements * n);
+    });
+}
+
+inline void encodeUnorm16(const float* source, size_t count, int components, void* destination, size_t stride)
+{
+    size_t n = (size_t)components;
+    detail::encode<uint16_t>(source, count, n, n, destination, stride, [n](const float* in, uint16_t* out, size_t elements) {
+        detail::unorm16Block(in, out, elements * n);
+    });
+}
+
+// count xyz normals into GL_INT_2_10_10_10_REV, with w = 0
+inline void encodeSnorm2101010(const float* source, size_t count, void* destination, size_t stride)
+{
+    detail::encode<uint32_t>(source, count, 3, 1, destination, stride, detail::snorm2101010Block);
+}
+
+} // namespace VertexEncoder
+
+#endif /* VertexEncoder_h */
@@ -0,0 +1,191 @@
+//
+//  VertexLayout.h
+//  OpenGL
+//
+//  Created by William Kpabitey Kwabla on 11/13/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*
+   Vertex attribute setup derived from the vertex struct itself. Strides, offsets, component
+   counts and GL types all come from the compiler, so the layout cannot drift from the data:
+
+       struct Vertex
+       {
+           float position[3];
+           float color[3];
+       };
+       using Layout = VertexLayout<Vertex,
+           VERTEX_ATTRIBUTE(Vertex, position, 0),
+           VERTEX_ATTRIBUTE(Vertex, color, 1)>;
+
+       Layout::configure(VAO, VBO);    // binds both and points locations 0 and 1 into VBO
+
+   A member is a scalar or an array of up to four of float, Half, int, unsigned int, short,
+   unsigned short, signed char or unsigned char, or a single Packed2101010. Integer members
+   reach the shader as floats; VERTEX_ATTRIBUTE_NORMALIZED maps them to [0, 1] or [-1, 1]
+   instead, and VERTEX_ATTRIBUTE_INTEGER passes them on as ints (glVertexAttribIPointer).
+   Half and Packed2101010 are the compressed formats VertexEncoder.h writes; a Packed2101010
+   is four components (x, y, z in 10 bits each, w in 2) and is normally normalized.
+
+   The layout fails to compile if an attribute is misaligned (offsets and the stride must be
+   multiples of 4, which every driver handles at full speed), if two attributes overlap or
+   share a location, or if the struct has bytes no attribute uses.
+ */
+enum class AttributeMode { Float, Normalized, Integer };
+
+// a 16-bit float, GL_HALF_FLOAT
+struct Half
+{
+    uint16_t bits;
+};
+
+// a signed x, y, z, w packed as 10:10:10:2 bits, GL_INT_2_10_10_10_REV
+struct Packed2101010
+{
+    uint32_t bits;
+};
+
+template <typename T> struct VertexComponent;
+template <> struct VertexComponent<float>          { static constexpr GLenum type = GL_FLOAT; static constexpr bool integer = false; };
+template <> struct VertexComponent<int32_t>        { static constexpr GLenum type = GL_INT; static constexpr bool integer = true; };
+template <> struct VertexComponent<uint32_t>       { static constexpr GLenum type = GL_UNSIGNED_INT; static constexpr bool integer = true; };
+template <> struct VertexComponent<int16_t>        { static constexpr GLenum type = GL_SHORT; static constexpr bool integer = true; };
+template <> struct VertexComponent<uint16_t>       { static constexpr GLenum type = GL_UNSIGNED_SHORT; static constexpr bool integer = true; };
+template <> struct VertexComponent<int8_t>         { static constexpr GLenum type = GL_BYTE; static constexpr bool integer = true; };
+template <> struct VertexComponent<uint8_t>        { static constexpr GLenum type = GL_UNSIGNED_BYTE; static constexpr bool integer = true; };
+template <> struct VertexComponent<Half>           { static constexpr GLenum type = GL_HALF_FLOAT; static constexpr bool integer = false; };
+template <> struct VertexComponent<Packed2101010>  { static constexpr GLenum type = GL_INT_2_10_10_10_REV; static constexpr bool integer = true; };
+
+// how many components a member has, and of what
+template <typename T> struct VertexMember
+{
+    using Component = T;
+    static constexpr GLint components = 1;
+};
+template <typename T, size_t N> struct VertexMember<T[N]>
+{
+    using Component = T;
+    static constexpr GLint components = (GLint)N;
+};
+template <> struct VertexMember<Packed2101010>
+{
+    using Component = Packed2101010;
+    static constexpr GLint components = 4;
+};
+
+template <GLuint Location, typename Member, size_t Offset, AttributeMode Mode = AttributeMode::Float>
+struct VertexAttribute
+{
+    using Component = VertexComponent<typename VertexMember<Member>::Component>;
+
+    static constexpr GLuint location = Location;
+    static constexpr size_t offset = Offset;
+    static constexpr size_t size = sizeof(Member);
+    static constexpr GLint components = VertexMember<Member>::components;
+    static constexpr GLenum type = Component::type;
+    static constexpr GLboolean normalized = Mode == AttributeMode::Normalized ? GL_TRUE : GL_FALSE;
+    static constexpr AttributeMode mode = Mode;
+
+    static_assert(components >= 1 && components <= 4, "a vertex attribute has one to four components");
+    static_assert(Offset % 4 == 0, "vertex attribute offsets must be multiples of 4 bytes");
+    static_assert(Mode == AttributeMode::Float || Component::integer, "only integer components can be normalized or passed as integers");
+    static_assert(type != GL_INT_2_10_10_10_REV || (Mode != AttributeMode::Integer && sizeof(Member) == 4), "a Packed2101010 attribute is one value, read as floats");
+
+    static void apply(GLsizei stride, GLuint divisor)
+    {
+        if (Mode == AttributeMode::Integer)
+            glVertexAttribIPointer(Location, components, type, stride, (const void*)Offset);
+        else
+            glVertexAttribPointer(Location, components, type, normalized, stride, (const void*)Offset);
+        glEnableVertexAttribArray(Location);
+        glVertexAttribDivisor(Location, divisor);
+    }
+};
+
+#define VERTEX_ATTRIBUTE(Vertex, member, location) \
+    VertexAttribute<(location), decltype(Vertex::member), offsetof(Vertex, member)>
+#define VERTEX_ATTRIBUTE_NORMALIZED(Vertex, member, location) \
+    VertexAttribute<(location), decltype(Vertex::member), offsetof(Vertex, member), AttributeMode::Normalized>
+#define VERTEX_ATTRIBUTE_INTEGER(Vertex, member, location) \
+    VertexAttribute<(location), decltype(Vertex::member), offsetof(Vertex, member), AttributeMode::Integer>
+
+
+namespace vertex_layout {
+
+constexpr size_t sum() { return 0; }
+template <typename... Rest>
+constexpr size_t sum(size_t first, Rest... rest) { return first + sum(rest...); }
+
+template <size_t N>
+constexpr bool distinct(const GLuint (&locations)[N])
+{
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = i + 1; j < N; ++j)
+            if (locations[i] == locations[j])
+                return false;
+    return true;
+}
+
+template <size_t N>
+constexpr bool disjoint(const size_t (&offsets)[N], const size_t (&sizes)[N])
+{
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = i + 1; j < N; ++j)
+            if (offsets[i] < offsets[j] + sizes[j] && offsets[j] < offsets[i] + sizes[i])
+                return false;
+    return true;
+}
+
+} // namespace vertex_layout
+
+
+template <typename Vertex, typename... Attributes>
+struct VertexLayout
+{
+    static constexpr GLsizei stride = (GLsizei)sizeof(Vertex);
+    static constexpr size_t attributeCount = sizeof...(Attributes);
+
+    static_assert(sizeof...(Attributes) > 0, "a vertex layout needs at least one attribute");
+    static_assert(sizeof(Vertex) % 4 == 0, "the vertex stride must be a multiple of 4 bytes");
+    static_assert(vertex_layout::distinct<sizeof...(Attributes)>({Attributes::location...}), "two attributes share a location");
+    static_assert(vertex_layout::disjoint<sizeof...(Attributes)>({Attributes::offset...}, {Attributes::size...}), "two attributes overlap");
+    static_assert(vertex_layout::sum(Attributes::size...) == sizeof(Vertex), "the vertex has padding or members no attribute reads");
+
+    // points every attribute into the bound GL_ARRAY_BUFFER, in the bound vertex array.
+    // divisor 1 makes them per-instance attributes.
+    // ------------------------------------------------------------------------
+    static void apply(GLuint divisor = 0)
+    {
+        int expand[] = { 0, (Attributes::apply(stride, divisor), 0)... };
+        (void)expand;
+    }
+
+    // calls visitor(attribute) with a value of each attribute type in turn, so generic code
+    // can read location, components, type, mode and offset off decltype(attribute)
+    template <typename Visitor>
+    static void visit(Visitor visitor)
+    {
+        int expand[] = { 0, (visitor(Attributes()), 0)... };
+        (void)expand;
+    }
+
+    // binds vertexArray and buffer, and applies the layout to them; both stay bound
+    static void configure(GLuint vertexArray, GLuint buffer, GLuint divisor = 0)
+    {
+        glBindVertexArray(vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        apply(divisor);
+    }
+};
+
+#endif /* VertexLayout_h */
@@ -8,6 +8,7 @@
 
 // Standard C++ libraries
 #include <iostream>
+#include <string>
 
 // Third-party libraries
 #ifdef __APPLE__
@@ -16,8 +17,15 @@
 #include <GLFW/glfw3.h>
 #else
 #include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
 #include <GLFW/glfw3.h>
 #endif
+#endif
+
+#include "../../OpenGL/OpenGL/src/StateCache.h"
+#include "../../OpenGL/OpenGL/src/PackedMesh.h"
 
 
 
@@ -134,48 +142,25 @@ int main() {
     
     
     
-       // set up vertex data (and buffer(s)) and configure vertex attributes
+       // load the rectangle's vertex data (and buffer(s)) with its vertex attributes already described
         // ------------------------------------------------------------------
-        float vertices[] = {
-             0.5f,  0.5f, 0.0f,  // top right
-             0.5f, -0.5f, 0.0f,  // bottom right
-            -0.5f, -0.5f, 0.0f,  // bottom left
-            -0.5f,  0.5f, 0.0f   // top left
-        };
-        unsigned int indices[] = {  // note that we start from 0!
-            0, 1, 3,  // first Triangle
-            1, 2, 3   // second Triangle
-        };
-        unsigned int VBO, VAO, EBO;
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-        // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        // remember: do NOT unbind the EBO while a VAO is active as the bound element buffer object IS stored in the VAO; keep the EBO bound.
-        //glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-        // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-        // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
-        glBindVertexArray(0);
+        // models/rectangle.mesh is packed from models/rectangle.obj by MeshPack; it is mapped
+        // and handed to the GL as is
+        const std::string sourceDirectory = std::string(__FILE__).substr(0, std::string(__FILE__).rfind('/') + 1);
+        PackedMesh rectangle;
+        if (!rectangle.load(sourceDirectory + "models/rectangle.mesh"))
+        {
+            glfwTerminate();
+            return -1;
+        }
 
 
         // uncomment this call to draw in wireframe polygons.
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
+        // binds go through the cache, so the ones repeated every frame never reach the driver
+        StateCache state;
+
         // render loop
         // -----------
         while (!glfwWindowShouldClose(window))
@@ -184,16 +169,17 @@ int main() {
             // -----
             processInput(window);
 
+            state.beginFrame();
+
             // render
             // ------
             glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
 
             // draw our first triangle
-            glUseProgram(shaderProgram);
-            glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
-            //glDrawArrays(GL_TRIANGLES, 0, 6);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            state.useProgram(shaderProgram);
+            state.bindVertexArray(rectangle.vertexArray()); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
+            rectangle.draw();
             // glBindVertexArray(0); // no need to unbind it every time
      
             // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -202,11 +188,11 @@ int main() {
             glfwPollEvents();
         }
 
+        state.printStats();
+
         // optional: de-allocate all resources once they've outlived their purpose:
         // ------------------------------------------------------------------------
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        rectangle.release();
 
         // glfw: terminate, clearing all previously allocated GLFW resources.
         // ------------------------------------------------------------------
@@ -0,0 +1,459 @@
+//
+//  main.cpp
+//  RenderQueue
+//
+//  Created by William Kpabitey Kwabla on 11/13/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+#include <cstdlib>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include "../../OpenGL/OpenGL/src/RenderQueue.h"
+#include "../../OpenGL/OpenGL/src/StateCache.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+GLuint createCheckerboard(float red, float green, float blue);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+const unsigned int OBJECT_COUNT = 20000;
+
+// uPlacement is xy offset, zw scale, in normalized device coordinates
+const char *solidVertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec2 aPos;\n"
+"uniform vec4 uPlacement;\n"
+"out vec2 position;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = vec4(aPos * uPlacement.zw + uPlacement.xy, 0.0, 1.0);\n"
+"   position = aPos;\n"
+"}\0";
+
+const char *solidFragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec2 position;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(position + 0.5, 0.6, 1.0);\n"
+"}\n\0";
+
+const char *texturedFragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec2 position;\n"
+"uniform sampler2D uTexture;\n"
+"void main()\n"
+"{\n"
+"   FragColor = texture(uTexture, position + 0.5);\n"
+"}\n\0";
+
+// what each recorded draw needs to know about a mesh
+struct Mesh
+{
+    GLuint vertexArray;
+    GLenum indexType;
+    GLsizei count;
+};
+
+struct Object
+{
+    float position[2];
+    float velocity[2];
+    float scale;
+    float depth;
+    int mesh;
+    int material;
+};
+
+// a program and the texture it samples (0 for none)
+struct Material
+{
+    GLuint program;
+    GLint placement;
+    GLuint texture;
+};
+
+
+int main() {
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "RenderQueue", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+
+    // two programs, three textures: four materials
+    // ------------------------------------
+    unsigned int solidProgram = createProgram(solidVertexShaderSource, solidFragmentShaderSource);
+    unsigned int texturedProgram = createProgram(solidVertexShaderSource, texturedFragmentShaderSource);
+    GLuint textures[] = {
+        createCheckerboard(1.0f, 0.5f, 0.2f),
+        createCheckerboard(0.2f, 0.8f, 0.4f),
+        createCheckerboard(0.3f, 0.4f, 1.0f)
+    };
+    std::vector<Material> materials = {
+        {solidProgram, glGetUniformLocation(solidProgram, "uPlacement"), 0},
+        {texturedProgram, glGetUniformLocation(texturedProgram, "uPlacement"), textures[0]},
+        {texturedProgram, glGetUniformLocation(texturedProgram, "uPlacement"), textures[1]},
+        {texturedProgram, glGetUniformLocation(texturedProgram, "uPlacement"), textures[2]}
+    };
+
+
+    // the triangle from HelloTriangle and the quad from Rectangle
+    // ------------------------------------------------------------------
+    float triangleVertices[] = {
+        -0.5f, -0.5f,
+         0.5f, -0.5f,
+         0.0f,  0.5f
+    };
+    float quadVertices[] = {
+         0.5f,  0.5f,  // top right
+         0.5f, -0.5f,  // bottom right
+        -0.5f, -0.5f,  // bottom left
+        -0.5f,  0.5f   // top left
+    };
+    unsigned int quadIndices[] = {
+        0, 1, 3,
+        1, 2, 3
+    };
+    unsigned int VAOs[2], VBOs[2], EBO;
+    glGenVertexArrays(2, VAOs);
+    glGenBuffers(2, VBOs);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAOs[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(VAOs[1]);
+    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), quadIndices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    const Mesh meshes[] = {
+        {VAOs[0], GL_NONE, 3},
+        {VAOs[1], GL_UNSIGNED_INT, 6}
+    };
+
+
+    // objects get their mesh and material at random, so in creation order nearly every draw
+    // changes some state
+    std::srand(11);
+    auto random = [](float low, float high) { return low + (high - low) * (float)std::rand() / (float)RAND_MAX; };
+    std::vector<Object> objects(OBJECT_COUNT);
+    for (Object& object : objects)
+    {
+        object.position[0] = random(-1.0f, 1.0f);
+        object.position[1] = random(-1.0f, 1.0f);
+        object.velocity[0] = random(-0.2f, 0.2f);
+        object.velocity[1] = random(-0.2f, 0.2f);
+        object.scale = random(0.01f, 0.04f);
+        object.depth = random(0.0f, 1.0f);
+        object.mesh = std::rand() % 2;
+        object.material = std::rand() % (int)materials.size();
+    }
+
+
+    // one recording thread per core, each with room for its share of the objects
+    unsigned threads = std::thread::hardware_concurrency();
+    threads = threads == 0 ? 4 : (threads > 16 ? 16 : threads);
+    const size_t objectsPerThread = (OBJECT_COUNT + threads - 1) / threads;
+    RenderQueue queue(threads, objectsPerThread);
+    StateCache state;
+    Profiler profiler;
+    double lastTime = glfwGetTime();
+
+    // moves a thread's share of the objects and records a draw for each; no GL calls here
+    auto record = [&](unsigned thread, float deltaTime) {
+        CommandBuffer& commands = queue.buffer(thread);
+        size_t begin = thread * objectsPerThread;
+        size_t end = std::min(begin + objectsPerThread, objects.size());
+        for (size_t i = begin; i < end; ++i)
+        {
+            Object& object = objects[i];
+            for (int axis = 0; axis < 2; ++axis)
+            {
+                object.position[axis] += object.velocity[axis] * deltaTime;
+                if (object.position[axis] < -1.0f || object.position[axis] > 1.0f)
+                    object.velocity[axis] = -object.velocity[axis];
+            }
+
+            const Mesh& mesh = meshes[object.mesh];
+            const Material& material = materials[object.material];
+            DrawCommand command;
+            command.key = SortKey::make(0, material.program, mesh.vertexArray, material.texture, object.depth);
+            command.program = material.program;
+            command.vertexArray = mesh.vertexArray;
+            command.texture = material.texture;
+            command.mode = GL_TRIANGLES;
+            command.indexType = mesh.indexType;
+            command.count = mesh.count;
+            command.first = 0;
+            command.indexOffset = 0;
+            command.uniform = material.placement;
+            command.data[0] = object.position[0];
+            command.data[1] = object.position[1];
+            command.data[2] = object.scale;
+            command.data[3] = object.scale;
+            commands.record(command);
+        }
+    };
+
+    // the recording threads live for the whole run: each frame the GL thread hands them the
+    // frame's delta time, wakes them, and sleeps until every one has finished its share
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    unsigned long frame = 0;
+    unsigned done = 0;
+    float frameDelta = 0.0f;
+    bool quit = false;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back([&, t] {
+            unsigned long recorded = 0;
+            for (;;)
+            {
+                float deltaTime;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return quit || frame != recorded; });
+                    if (quit)
+                        return;
+                    recorded = frame;
+                    deltaTime = frameDelta;
+                }
+                record(t, deltaTime);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (++done == threads)
+                    finished.notify_one();
+            }
+        });
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+        state.beginFrame();
+
+        double now = glfwGetTime();
+        float deltaTime = (float)(now - lastTime);
+        lastTime = now;
+
+        // scene traversal on every core
+        profiler.begin("record");
+        queue.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameDelta = deltaTime;
+            done = 0;
+            ++frame;
+            wake.notify_all();
+            finished.wait(lock, [&] { return done == threads; });
+        }
+        profiler.end();
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        profiler.begin("submit");
+        queue.submit(state);
+        profiler.end();
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    const RenderQueue::Stats& stats = queue.stats();
+    std::cout << "RENDER_QUEUE commands: " << stats.commands << " per frame from " << threads << " threads, dropped: " << stats.dropped
+              << " sort: " << (stats.frames > 0 ? stats.sortMilliseconds / stats.frames : 0.0) << " ms per frame" << std::endl;
+    state.printStats();
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteVertexArrays(2, VAOs);
+    glDeleteBuffers(2, VBOs);
+    glDeleteBuffers(1, &EBO);
+    glDeleteTextures(3, textures);
+    glDeleteProgram(solidProgram);
+    glDeleteProgram(texturedProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ a 8x8 checkerboard of color and white
+ */
+GLuint createCheckerboard(float red, float green, float blue)
+{
+    const float color[] = { red, green, blue, 1.0f };
+    unsigned char pixels[8 * 8 * 4];
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 8; ++x)
+        {
+            bool white = ((x + y) & 1) != 0;
+            for (int c = 0; c < 4; ++c)
+                pixels[(y * 8 + x) * 4 + c] = white ? 255 : (unsigned char)(color[c] * 255.0f);
+        }
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 8, 8, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
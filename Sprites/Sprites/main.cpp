@@ -0,0 +1,229 @@
+//
+//  main.cpp
+//  Sprites
+//
+//  Created by William Kpabitey Kwabla on 11/10/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include <glm/glm.hpp>
+
+#include "../../OpenGL/OpenGL/src/BatchRenderer.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+GLuint createCheckerboard(const glm::vec4& color);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+const unsigned int SPRITE_COUNT = 100000;
+
+struct Sprite
+{
+    glm::vec2 position;
+    glm::vec2 velocity;
+    glm::vec4 color;
+    GLuint texture;
+};
+
+
+int main() {
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Sprites", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+
+    // three textures plus untextured quads, so every batch mixes texture units
+    // ------------------------------------------------------------------------
+    GLuint textures[] = {
+        0,
+        createCheckerboard(glm::vec4(1.0f, 0.5f, 0.2f, 1.0f)),
+        createCheckerboard(glm::vec4(0.2f, 0.8f, 0.4f, 1.0f)),
+        createCheckerboard(glm::vec4(0.3f, 0.4f, 1.0f, 1.0f))
+    };
+
+    // sprites start scattered over the screen (in normalized device coordinates) and drift
+    std::srand(42);
+    auto random = [](float low, float high) { return low + (high - low) * (float)std::rand() / (float)RAND_MAX; };
+    std::vector<Sprite> sprites(SPRITE_COUNT);
+    for (unsigned int i = 0; i < SPRITE_COUNT; ++i)
+    {
+        sprites[i].position = glm::vec2(random(-1.0f, 0.99f), random(-1.0f, 0.99f));
+        sprites[i].velocity = glm::vec2(random(-0.2f, 0.2f), random(-0.2f, 0.2f));
+        sprites[i].color = glm::vec4(random(0.5f, 1.0f), random(0.5f, 1.0f), random(0.5f, 1.0f), 1.0f);
+        sprites[i].texture = textures[i % 4];
+    }
+    const glm::vec2 spriteSize(0.01f, 0.0133f);
+
+    BatchRenderer batch;
+    Profiler profiler;
+    double lastTime = glfwGetTime();
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+
+        double now = glfwGetTime();
+        float deltaTime = (float)(now - lastTime);
+        lastTime = now;
+
+        // bounce off the edges of the screen
+        profiler.begin("update");
+        for (Sprite& sprite : sprites)
+        {
+            sprite.position += sprite.velocity * deltaTime;
+            if (sprite.position.x < -1.0f || sprite.position.x > 0.99f)
+                sprite.velocity.x = -sprite.velocity.x;
+            if (sprite.position.y < -1.0f || sprite.position.y > 0.99f)
+                sprite.velocity.y = -sprite.velocity.y;
+        }
+        profiler.end();
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        profiler.begin("batch");
+        batch.beginBatch();
+        for (const Sprite& sprite : sprites)
+            batch.submitQuad(sprite.position, spriteSize, sprite.color, sprite.texture);
+        batch.flush();
+        profiler.end();
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    std::cout << "SPRITES quads: " << batch.getStats().quads << " draw calls: " << batch.getStats().drawCalls << " per frame" << std::endl;
+    const StreamBuffer::Stats& stream = batch.getStreamStats();
+    std::cout << "SPRITES stream frames: " << stream.frames << " stalls: " << stream.stalls << " (" << stream.stallMilliseconds << " ms)"
+              << " early advances: " << stream.earlyAdvances << " bytes: " << stream.bytes << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteTextures(3, &textures[1]);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+/*
+ a 8x8 checkerboard of color and white, so the texture is visible under the vertex color
+ */
+GLuint createCheckerboard(const glm::vec4& color)
+{
+    unsigned char pixels[8 * 8 * 4];
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 8; ++x)
+        {
+            bool white = ((x + y) & 1) != 0;
+            for (int c = 0; c < 4; ++c)
+                pixels[(y * 8 + x) * 4 + c] = white ? 255 : (unsigned char)(color[c] * 255.0f);
+        }
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 8, 8, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
@@ -0,0 +1,390 @@
+//
+//  main.cpp
+//  VertexFormats
+//
+//  Created by William Kpabitey Kwabla on 11/14/19.
+//  Copyright © 2019 William Kpabitey Kwabla. All rights reserved.
+//
+
+// Standard C++ libraries
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Third-party libraries
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#else
+#include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
+#include <GLFW/glfw3.h>
+#endif
+#endif
+
+#include "../../OpenGL/OpenGL/src/VertexLayout.h"
+#include "../../OpenGL/OpenGL/src/VertexEncoder.h"
+#include "../../OpenGL/OpenGL/src/Profiler.h"
+
+
+
+// Function Prototypes
+void processInput(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow *window, int height, int width);
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+
+// Constants
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// a GRID x GRID vertex height field, about two million triangles, drawn DRAWS times per format
+// per frame so that vertex fetch dominates
+const int GRID = 1024;
+const int DRAWS = 2;
+
+// the same shader reads both formats; the GL expands the compressed attributes to floats
+const char *vertexShaderSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec3 aColor;\n"
+"layout (location = 2) in vec3 aNormal;\n"
+"layout (location = 3) in vec2 aTexCoord;\n"
+"out vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = vec4(aPos.xy, aPos.z * 0.5, 1.0);\n"
+"   float light = 0.4 + 0.6 * max(dot(normalize(aNormal), normalize(vec3(0.3, 0.5, 1.0))), 0.0);\n"
+"   float checker = mod(floor(aTexCoord.x * 16.0) + floor(aTexCoord.y * 16.0), 2.0);\n"
+"   ourColor = aColor * light * (0.75 + 0.25 * checker);\n"
+"}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"in vec3 ourColor;\n"
+"void main()\n"
+"{\n"
+"   FragColor = vec4(ourColor, 1.0f);\n"
+"}\n\0";
+
+// 44 bytes: everything as 32-bit floats, as in moreAttributes
+struct FloatVertex
+{
+    float position[3];
+    float color[3];
+    float normal[3];
+    float texCoord[2];
+};
+using FloatLayout = VertexLayout<FloatVertex,
+    VERTEX_ATTRIBUTE(FloatVertex, position, 0),
+    VERTEX_ATTRIBUTE(FloatVertex, color, 1),
+    VERTEX_ATTRIBUTE(FloatVertex, normal, 2),
+    VERTEX_ATTRIBUTE(FloatVertex, texCoord, 3)>;
+
+// 20 bytes: half positions (w = 1), 8-bit colors (alpha 1), 10:10:10:2 normals, 16-bit texcoords
+struct CompressedVertex
+{
+    Half position[4];
+    uint8_t color[4];
+    Packed2101010 normal;
+    uint16_t texCoord[2];
+};
+using CompressedLayout = VertexLayout<CompressedVertex,
+    VERTEX_ATTRIBUTE(CompressedVertex, position, 0),
+    VERTEX_ATTRIBUTE_NORMALIZED(CompressedVertex, color, 1),
+    VERTEX_ATTRIBUTE_NORMALIZED(CompressedVertex, normal, 2),
+    VERTEX_ATTRIBUTE_NORMALIZED(CompressedVertex, texCoord, 3)>;
+
+// the source data, one stream per attribute, as a loader would hand it over
+struct Streams
+{
+    std::vector<float> positions;   // xyzw
+    std::vector<float> colors;      // rgba
+    std::vector<float> normals;     // xyz
+    std::vector<float> texCoords;   // uv
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main() {
+
+
+    /* Initialize glfw library */
+    if(!glfwInit()){
+        std::cout<<"glfwInit Failed to initailze" <<std::endl;
+        return -1;
+    }
+
+    /* Configure GLFW */
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+
+     /* Create a windowed mode window and its OpenGL context */
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "VertexFormats", nullptr, nullptr);
+
+    if(window == NULL){
+        std::cout<<"Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // initialise GLEW
+    glewExperimental = GL_TRUE; //stops glew crashing on OSX :-/
+    if(glewInit() != GLEW_OK) {
+
+        std::cout<<"glewInit Failed to initialize"<<std::endl;
+        return -1;
+    }
+
+    unsigned int shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+
+
+    // a rolling height field over the whole screen
+    // ------------------------------------------------------------------
+    const size_t vertexCount = (size_t)GRID * GRID;
+    Streams source;
+    source.positions.resize(vertexCount * 4);
+    source.colors.resize(vertexCount * 4);
+    source.normals.resize(vertexCount * 3);
+    source.texCoords.resize(vertexCount * 2);
+    for (int y = 0; y < GRID; ++y)
+        for (int x = 0; x < GRID; ++x)
+        {
+            size_t i = (size_t)(y * GRID + x);
+            float u = (float)x / (GRID - 1);
+            float v = (float)y / (GRID - 1);
+            float px = u * 2.0f - 1.0f;
+            float py = v * 2.0f - 1.0f;
+            float height = 0.5f * std::sin(px * 6.0f) * std::cos(py * 4.0f);
+            float dx = 3.0f * std::cos(px * 6.0f) * std::cos(py * 4.0f);
+            float dy = -2.0f * std::sin(px * 6.0f) * std::sin(py * 4.0f);
+            float length = std::sqrt(dx * dx + dy * dy + 1.0f);
+            float* position = &source.positions[i * 4];
+            position[0] = px; position[1] = py; position[2] = height; position[3] = 1.0f;
+            float* color = &source.colors[i * 4];
+            color[0] = u; color[1] = 0.5f + 0.5f * height; color[2] = 1.0f - u; color[3] = 1.0f;
+            float* normal = &source.normals[i * 3];
+            normal[0] = -dx / length; normal[1] = -dy / length; normal[2] = 1.0f / length;
+            source.texCoords[i * 2] = u;
+            source.texCoords[i * 2 + 1] = v;
+        }
+
+    std::vector<FloatVertex> floatVertices(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            floatVertices[i].position[c] = source.positions[i * 4 + c];
+            floatVertices[i].color[c] = source.colors[i * 4 + c];
+            floatVertices[i].normal[c] = source.normals[i * 3 + c];
+        }
+        floatVertices[i].texCoord[0] = source.texCoords[i * 2];
+        floatVertices[i].texCoord[1] = source.texCoords[i * 2 + 1];
+    }
+
+
+    // encode: bulk SIMD conversion, then the same one value at a time for comparison
+    // ------------------------------------------------------------------
+    std::vector<CompressedVertex> compressedVertices(vertexCount);
+    auto start = std::chrono::steady_clock::now();
+    VertexEncoder::encodeHalf(source.positions.data(), vertexCount, 4, &compressedVertices[0].position, sizeof(CompressedVertex));
+    VertexEncoder::encodeUnorm8(source.colors.data(), vertexCount, 4, &compressedVertices[0].color, sizeof(CompressedVertex));
+    VertexEncoder::encodeSnorm2101010(source.normals.data(), vertexCount, &compressedVertices[0].normal, sizeof(CompressedVertex));
+    VertexEncoder::encodeUnorm16(source.texCoords.data(), vertexCount, 2, &compressedVertices[0].texCoord, sizeof(CompressedVertex));
+    double simdMilliseconds = millisecondsSince(start);
+
+    std::vector<CompressedVertex> scalarVertices(vertexCount);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        CompressedVertex& vertex = scalarVertices[i];
+        for (int c = 0; c < 4; ++c)
+        {
+            vertex.position[c].bits = VertexEncoder::toHalf(source.positions[i * 4 + c]);
+            vertex.color[c] = VertexEncoder::toUnorm8(source.colors[i * 4 + c]);
+        }
+        vertex.normal.bits = VertexEncoder::toSnorm2101010(&source.normals[i * 3]);
+        vertex.texCoord[0] = VertexEncoder::toUnorm16(source.texCoords[i * 2]);
+        vertex.texCoord[1] = VertexEncoder::toUnorm16(source.texCoords[i * 2 + 1]);
+    }
+    double scalarMilliseconds = millisecondsSince(start);
+
+    bool identical = std::memcmp(compressedVertices.data(), scalarVertices.data(), vertexCount * sizeof(CompressedVertex)) == 0;
+    float positionError = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i)
+        for (int c = 0; c < 3; ++c)
+            positionError = std::max(positionError, std::fabs(VertexEncoder::fromHalf(compressedVertices[i].position[c].bits) - source.positions[i * 4 + c]));
+
+
+    // one index buffer, two vertex buffers
+    // ------------------------------------------------------------------
+    std::vector<GLuint> indices;
+    indices.reserve((size_t)(GRID - 1) * (GRID - 1) * 6);
+    for (int y = 0; y + 1 < GRID; ++y)
+        for (int x = 0; x + 1 < GRID; ++x)
+        {
+            GLuint corner = (GLuint)(y * GRID + x);
+            GLuint quad[] = { corner, corner + 1, corner + GRID, corner + 1, corner + GRID + 1, corner + GRID };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+
+    unsigned int VAOs[2], VBOs[2], EBO;
+    glGenVertexArrays(2, VAOs);
+    glGenBuffers(2, VBOs);
+    glGenBuffers(1, &EBO);
+
+    FloatLayout::configure(VAOs[0], VBOs[0]);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(vertexCount * sizeof(FloatVertex)), floatVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(indices.size() * sizeof(GLuint)), indices.data(), GL_STATIC_DRAW);
+
+    CompressedLayout::configure(VAOs[1], VBOs[1]);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(vertexCount * sizeof(CompressedVertex)), compressedVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+    Profiler profiler;
+
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // input
+        // -----
+        processInput(window);
+
+        profiler.beginFrame();
+
+        // render
+        // ------
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glUseProgram(shaderProgram);
+
+        // the same mesh in each format, the compressed one last so it is what shows
+        const char* sections[] = { "float", "compressed" };
+        for (int format = 0; format < 2; ++format)
+        {
+            profiler.begin(sections[format]);
+            glBindVertexArray(VAOs[format]);
+            for (int draw = 0; draw < DRAWS; ++draw)
+                glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
+            profiler.end();
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        profiler.endFrame();
+        glfwPollEvents();
+    }
+
+    profiler.finish();
+    Profiler::Stats floatStats = profiler.stats("float");
+    Profiler::Stats compressedStats = profiler.stats("compressed");
+    const double megabyte = 1024.0 * 1024.0;
+    std::cout << "VERTEX_FORMATS vertices: " << vertexCount << " triangles: " << indices.size() / 3 << " x " << DRAWS << " draws per format per frame" << std::endl;
+    std::cout << "VERTEX_FORMATS float:      " << sizeof(FloatVertex) << " bytes/vertex (" << vertexCount * sizeof(FloatVertex) / megabyte << " MB)"
+              << " gpu p50: " << floatStats.gpu[0] << " ms" << std::endl;
+    std::cout << "VERTEX_FORMATS compressed: " << sizeof(CompressedVertex) << " bytes/vertex (" << vertexCount * sizeof(CompressedVertex) / megabyte << " MB)"
+              << " gpu p50: " << compressedStats.gpu[0] << " ms" << std::endl;
+    std::cout << "VERTEX_FORMATS encode " << VertexEncoder::simdPath() << ": " << simdMilliseconds << " ms, scalar: " << scalarMilliseconds << " ms"
+              << (identical ? " (identical output)" : " (OUTPUT DIFFERS)") << ", max position error: " << positionError << std::endl;
+    profiler.report();
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteVertexArrays(2, VAOs);
+    glDeleteBuffers(2, VBOs);
+    glDeleteBuffers(1, &EBO);
+    glDeleteProgram(shaderProgram);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+
+unsigned int createProgram(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    int success;
+    char infoLog[512];
+
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return shaderProgram;
+}
+
+
+/*
+ process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+ */
+void processInput(GLFWwindow* window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+
+/*
+ glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+ */
+void framebuffer_size_callback(GLFWwindow *window, int height, int width) {
+
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+
+    glViewport(0, 0, height, width);
+
+}
@@ -16,8 +16,12 @@
 #include <GLFW/glfw3.h>
 #else
 #include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
 #include <GLFW/glfw3.h>
 #endif
+#endif
 
 
 
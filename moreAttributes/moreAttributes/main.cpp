@@ -16,8 +16,14 @@
 #include <GLFW/glfw3.h>
 #else
 #include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
 #include <GLFW/glfw3.h>
 #endif
+#endif
+
+#include "../../OpenGL/OpenGL/src/VertexLayout.h"
 
 
 
@@ -48,6 +54,16 @@ const char *fragmentShaderSource = "#version 330 core\n"
 "   FragColor = vec4(ourColor, 1.0f);\n"
 "}\n\0";
 
+// Matches aPos and aColor in the vertex shader.
+struct Vertex
+{
+    float position[3];
+    float color[3];
+};
+using VertexAttributes = VertexLayout<Vertex,
+    VERTEX_ATTRIBUTE(Vertex, position, 0),
+    VERTEX_ATTRIBUTE(Vertex, color, 1)>;
+
 int main() {
     
     
@@ -138,30 +154,20 @@ int main() {
     
     
     
-    float vertices[] = {
-        // positions         // colors
-        0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom right
-       -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, // bottom left
-        0.0f,  0.5f, 0.0f, 0.0f, 0.0f, 1.0f    // top
+    Vertex vertices[] = {
+        // positions             // colors
+        {{ 0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}}, // bottom right
+        {{-0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}}, // bottom left
+        {{ 0.0f,  0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}}  // top
     };
     
     unsigned int VBO, VAO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
-    // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    // bind the Vertex Array Object and vertex buffer, and set up the position and color attributes from the Vertex struct
+    VertexAttributes::configure(VAO, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    // color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
     // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -17,8 +17,14 @@
 #include <GLFW/glfw3.h>
 #else
 #include <GL/glew.h>
+#ifdef HEADLESS
+#include "../../OpenGL/OpenGL/src/Headless.h"
+#else
 #include <GLFW/glfw3.h>
 #endif
+#endif
+
+#include "../../OpenGL/OpenGL/src/UniformBuffer.h"
 
 
 
@@ -40,12 +46,25 @@ const char *vertexShaderSource = "#version 330 core\n"
 
 const char *fragmentShaderSource = "#version 330 core\n"
 "out vec4 FragColor;\n"
-"uniform vec4 ourColor;\n"
+"layout (std140) uniform Color\n"
+"{\n"
+"   vec4 ourColor;\n"
+"};\n"
 "void main()\n"
 "{\n"
 "   FragColor = ourColor;\n"
 "}\n\0";
 
+// the C++ side of the Color block above
+struct ColorBlock
+{
+    std140::Vec4 ourColor;
+};
+STD140_OFFSET(ColorBlock, ourColor, 0);
+STD140_SIZE(ColorBlock, 16);
+
+const GLuint COLOR_BINDING = 0;
+
 int main() {
     
     
@@ -161,6 +180,10 @@ int main() {
     // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
     glBindVertexArray(0);
 
+    // ourColor comes from a uniform block, written once per frame into a ring of buffer ranges
+    UniformBuffers uniforms;
+    uniforms.declare<ColorBlock>("Color", COLOR_BINDING);
+    uniforms.attach(shaderProgram);
     
     
     /* Loop until the user closes the window */
@@ -182,12 +205,14 @@ int main() {
         // update the uniform color
         float timeValue = glfwGetTime();
         float greenValue = sin(timeValue) / 2.0f + 0.5f;
-        int vertexColorLocation = glGetUniformLocation(shaderProgram, "ourColor");
-        glUniform4f(vertexColorLocation, 0.0f, greenValue, 0.0f, 1.0f);
+        ColorBlock color;
+        color.ourColor = std140::Vec4(0.0f, greenValue, 0.0f, 1.0f);
+        uniforms.upload(COLOR_BINDING, color);
         
         glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
         glDrawArrays(GL_TRIANGLES, 0, 3);
         
+        uniforms.endFrame();
 
         /* Swap front and back buffers */
         glfwSwapBuffers(window);